@@ -4,96 +4,551 @@
 #include <thread>
 #include <random>
 #include <algorithm>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <array>
+#include <memory>
+#include <string>
+#include <source_location>
+#include <shared_mutex>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Лог2-гистограмма длительностей в наносекундах:
+// бакет i хранит значения из [2^(i-1), 2^i)
+class LockHistogram {
+public:
+    static constexpr size_t BUCKETS = 40; // до ~9 минут
+    
+    void record(uint64_t ns) {
+        size_t bucket = std::min<size_t>(64 - __builtin_clzll(ns | 1) - (ns == 0), BUCKETS - 1);
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+    
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (const auto& bucket : buckets_) total += bucket.load(std::memory_order_relaxed);
+        return total;
+    }
+    
+    // Верхняя граница бакета, в который попадает квантиль q
+    uint64_t percentile(double q) const {
+        uint64_t total = count();
+        if (total == 0) return 0;
+        
+        uint64_t rank = static_cast<uint64_t>(q * total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                return std::min<uint64_t>(i == 0 ? 0 : (1ull << i) - 1, max());
+            }
+        }
+        return max();
+    }
+    
+    uint64_t max() const {
+        return max_.load(std::memory_order_relaxed);
+    }
+    
+    void reset() {
+        for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+    
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Место вызова lock(), которому пришлось ждать
+struct LockCallSite {
+    const char* file;
+    uint32_t line;
+    const char* function;
+    uint64_t waits;
+    uint64_t total_wait_ns;
+};
+
+// Профиль одного именованного мьютекса. Записывается в среднем одно из
+// sample_period захватываний, чтобы профилирование не становилось
+// источником конкуренции
+class LockProfile {
+public:
+    explicit LockProfile(std::string name, uint32_t sample_period = 16)
+        : name_(std::move(name)), sample_period_(std::max(sample_period, 1u)) {}
+    
+    const std::string& name() const { return name_; }
+    
+    // Случайная выборка (xorshift): периодический счетчик, общий для всех
+    // мьютексов потока, давал бы алиасинг при чередовании блокировок
+    bool should_sample() const {
+        thread_local uint32_t state = 0x9E3779B9u ^
+            static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % sample_period_ == 0;
+    }
+    
+    void record_acquire(uint64_t wait_ns, const std::source_location& location) {
+        samples_.fetch_add(1, std::memory_order_relaxed);
+        wait_ns_.record(wait_ns);
+        
+        if (wait_ns == 0) return;
+        
+        contended_samples_.fetch_add(1, std::memory_order_relaxed);
+        total_wait_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+        
+        if (CallSiteSlot* slot = find_call_site(location)) {
+            slot->waits.fetch_add(1, std::memory_order_relaxed);
+            slot->wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+        }
+    }
+    
+    void record_hold(uint64_t hold_ns) {
+        hold_ns_.record(hold_ns);
+    }
+    
+    uint64_t total_wait_ns() const {
+        return total_wait_ns_.load(std::memory_order_relaxed);
+    }
+    
+    std::vector<LockCallSite> top_call_sites(size_t n) const {
+        std::vector<LockCallSite> sites;
+        for (const auto& slot : call_sites_) {
+            uint64_t key = slot.key.load(std::memory_order_acquire);
+            if (key == 0 || key == BUSY_KEY) continue;
+            sites.push_back({
+                slot.file.load(std::memory_order_relaxed),
+                slot.line.load(std::memory_order_relaxed),
+                slot.function.load(std::memory_order_relaxed),
+                slot.waits.load(std::memory_order_relaxed),
+                slot.wait_ns.load(std::memory_order_relaxed)
+            });
+        }
+        
+        std::sort(sites.begin(), sites.end(), [](const LockCallSite& a, const LockCallSite& b) {
+            return a.total_wait_ns > b.total_wait_ns;
+        });
+        if (sites.size() > n) sites.resize(n);
+        return sites;
+    }
+    
+    void report(std::ostream& out, size_t top_n) const {
+        uint64_t samples = samples_.load(std::memory_order_relaxed);
+        uint64_t contended = contended_samples_.load(std::memory_order_relaxed);
+        
+        out << "Lock '" << name_ << "': " << samples << " samples, "
+            << std::fixed << std::setprecision(1)
+            << (samples ? 100.0 * contended / samples : 0.0) << "% contended, "
+            << "sampled wait " << total_wait_ns() / 1000 << " us\n"
+            << "  wait ns p50/p99/max: " << wait_ns_.percentile(0.5) << " / "
+            << wait_ns_.percentile(0.99) << " / " << wait_ns_.max() << "\n"
+            << "  hold ns p50/p99/max: " << hold_ns_.percentile(0.5) << " / "
+            << hold_ns_.percentile(0.99) << " / " << hold_ns_.max() << "\n";
+        
+        for (const auto& site : top_call_sites(top_n)) {
+            out << "    " << site.file << ":" << site.line << " (" << site.function << "): "
+                << site.waits << " waits, " << site.total_wait_ns / 1000 << " us\n";
+        }
+        
+        uint64_t dropped = dropped_call_sites_.load(std::memory_order_relaxed);
+        if (dropped > 0) {
+            out << "    (" << dropped << " waits from untracked call sites)\n";
+        }
+    }
+    
+    void reset() {
+        samples_.store(0, std::memory_order_relaxed);
+        contended_samples_.store(0, std::memory_order_relaxed);
+        total_wait_ns_.store(0, std::memory_order_relaxed);
+        wait_ns_.reset();
+        hold_ns_.reset();
+        for (auto& slot : call_sites_) {
+            slot.waits.store(0, std::memory_order_relaxed);
+            slot.wait_ns.store(0, std::memory_order_relaxed);
+        }
+    }
+    
+private:
+    static constexpr size_t MAX_CALL_SITES = 64;
+    static constexpr uint64_t BUSY_KEY = 2;   // слот заполняется; настоящие ключи нечетные
+    
+    // Lock-free хеш-таблица мест вызова с открытой адресацией.
+    // Слот занимается CAS'ом ключа 0 -> BUSY_KEY, заполняется и только
+    // потом публикует настоящий ключ (хеш file+line) release-записью
+    struct CallSiteSlot {
+        std::atomic<uint64_t> key{0};
+        std::atomic<const char*> file{nullptr};
+        std::atomic<uint32_t> line{0};
+        std::atomic<const char*> function{nullptr};
+        std::atomic<uint64_t> waits{0};
+        std::atomic<uint64_t> wait_ns{0};
+    };
+    
+    CallSiteSlot* find_call_site(const std::source_location& location) {
+        uint64_t key = std::hash<const char*>{}(location.file_name()) * 31 + location.line();
+        key |= 1; // 0 - признак свободного слота
+        
+        for (size_t probe = 0; probe < MAX_CALL_SITES; ++probe) {
+            CallSiteSlot& slot = call_sites_[(key + probe) % MAX_CALL_SITES];
+            uint64_t current = slot.key.load(std::memory_order_acquire);
+            
+            if (current == 0 &&
+                slot.key.compare_exchange_strong(current, BUSY_KEY, std::memory_order_acquire)) {
+                slot.file.store(location.file_name(), std::memory_order_relaxed);
+                slot.line.store(location.line(), std::memory_order_relaxed);
+                slot.function.store(location.function_name(), std::memory_order_relaxed);
+                slot.key.store(key, std::memory_order_release);
+                return &slot;
+            }
+            // Слот может оказаться нашим - дожидаемся его ключа
+            while (current == BUSY_KEY) {
+                std::this_thread::yield();
+                current = slot.key.load(std::memory_order_acquire);
+            }
+            if (current == key) return &slot;
+        }
+        
+        dropped_call_sites_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    
+    std::string name_;
+    uint32_t sample_period_;
+    
+    std::atomic<uint64_t> samples_{0};
+    std::atomic<uint64_t> contended_samples_{0};
+    std::atomic<uint64_t> total_wait_ns_{0};
+    std::atomic<uint64_t> dropped_call_sites_{0};
+    LockHistogram wait_ns_;
+    LockHistogram hold_ns_;
+    std::array<CallSiteSlot, MAX_CALL_SITES> call_sites_;
+};
+
+// Реестр профилируемых мьютексов: отчет по всем блокировкам процесса,
+// отсортированный по суммарному ожиданию
+class LockRegistry {
+public:
+    static LockRegistry& instance() {
+        static LockRegistry registry;
+        return registry;
+    }
+    
+    void add(LockProfile* profile) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        profiles_.push_back(profile);
+    }
+    
+    void remove(LockProfile* profile) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        profiles_.erase(std::remove(profiles_.begin(), profiles_.end(), profile), profiles_.end());
+    }
+    
+    void report(std::ostream& out = std::cout, size_t top_call_sites = 5) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        std::vector<const LockProfile*> sorted(profiles_.begin(), profiles_.end());
+        std::sort(sorted.begin(), sorted.end(), [](const LockProfile* a, const LockProfile* b) {
+            return a->total_wait_ns() > b->total_wait_ns();
+        });
+        
+        out << "Lock Contention Report (" << sorted.size() << " locks):\n";
+        for (const LockProfile* profile : sorted) {
+            profile->report(out, top_call_sites);
+        }
+    }
+    
+private:
+    mutable std::mutex mutex_;
+    std::vector<LockProfile*> profiles_;
+};
+
+// Дешевые часы для медленного пути: TSC на x86, steady_clock в остальных
+// случаях. Перевод в наносекунды калибруется один раз
+namespace adaptive_clock
+{
+    inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+    
+    inline double ticks_per_ns() {
+        static const double ratio = []() {
+#if defined(__x86_64__) || defined(__i386__)
+            auto start_time = std::chrono::steady_clock::now();
+            uint64_t start_ticks = ticks();
+            while (std::chrono::steady_clock::now() - start_time < std::chrono::milliseconds(2)) {
+            }
+            uint64_t elapsed_ticks = ticks() - start_ticks;
+            double elapsed_ns = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start_time).count();
+            return elapsed_ticks / elapsed_ns;
+#else
+            return 1.0;
+#endif
+        }();
+        return ratio;
+    }
+    
+    inline uint64_t to_ns(uint64_t tick_count) {
+        return static_cast<uint64_t>(tick_count / ticks_per_ns());
+    }
+}
+
+// Ожидание, пока word != busy_value: сначала спин с yield, затем парковка
+// на word (atomic::wait). Сторона, меняющая word, обязана вызвать notify
+inline void adaptive_wait(const std::atomic<uint32_t>& word, uint32_t busy_value,
+                          uint32_t spin_limit) {
+    for (uint32_t i = 0; i < spin_limit; ++i) {
+        if (word.load(std::memory_order_acquire) != busy_value) return;
+        std::this_thread::yield();
+    }
+    while (word.load(std::memory_order_acquire) == busy_value) {
+        word.wait(busy_value, std::memory_order_acquire);
+    }
+}
 
 class AdaptiveMutex {
+public:
+    // Режим ожидания под конкуренцией
+    enum class LockMode : uint32_t {
+        Adaptive, // переключение по наблюдаемой конкуренции (adapt_parameters)
+        Spin,     // TTAS-спин всех ожидающих по state_, затем парковка
+        Queued    // MCS-очередь: каждый ожидающий спинит на своей кеш-линии, FIFO
+    };
+    
 private:
-    enum class State : uint32_t {
-        UNLOCKED = 0,
-        LOCKED = 1,
-        LOCKED_WITH_WAITERS = 2
+    // Биты state_
+    static constexpr uint32_t LOCKED_BIT = 1;  // мьютекс захвачен
+    static constexpr uint32_t WAITERS_BIT = 2; // на state_ могут быть припаркованы потоки
+    static constexpr uint32_t QUEUED_BIT = 4;  // MCS-очередь непуста: быстрый путь закрыт
+    
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    
+    // Узел MCS-очереди живет на стеке ожидающего потока
+    struct alignas(CACHE_LINE_SIZE) QueueNode {
+        std::atomic<QueueNode*> next{nullptr};
+        std::atomic<uint32_t> is_head{0};
     };
     
-    std::atomic<uint32_t> state_{static_cast<uint32_t>(State::UNLOCKED)};
+    // Как был получен мьютекс на медленном пути
+    enum class SlowPath { Spin, Park, Queue };
     
-    // Статистика для адаптации
-    mutable std::atomic<uint64_t> total_acquisitions_{0};
-    mutable std::atomic<uint64_t> spin_acquisitions_{0};
-    mutable std::atomic<uint64_t> sleep_acquisitions_{0};
-    mutable std::atomic<uint64_t> total_contention_time_{0}; // в наносекундах
+    // Статистика медленного пути и адаптивные параметры. Живут на своих
+    // кеш-линиях, чтобы запись в них не конфликтовала со словом блокировки
+    struct alignas(CACHE_LINE_SIZE) Tuning {
+        std::atomic<uint64_t> slow_acquisitions{0};
+        std::atomic<uint64_t> spin_acquisitions{0};
+        std::atomic<uint64_t> sleep_acquisitions{0};
+        std::atomic<uint64_t> queued_acquisitions{0};
+        std::atomic<uint64_t> total_parks{0};
+        std::atomic<uint64_t> total_spins{0};
+        std::atomic<uint64_t> contention_ticks{0};
+        
+        // Счетчики текущего интервала адаптации
+        std::atomic<uint64_t> interval_slow{0};
+        std::atomic<uint64_t> interval_spin{0};
+        std::atomic<uint64_t> interval_park{0};
+        std::atomic<uint64_t> last_adaptation_ticks{0};
+        
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> spin_limit{1000};
+        std::atomic<LockMode> mode_policy{LockMode::Adaptive};
+        std::atomic<bool> queued_mode{false};
+        std::atomic<uint64_t> mode_switches{0};
+    };
     
-    // Адаптивные параметры
-    mutable std::atomic<uint32_t> spin_limit_{1000};
-    mutable std::atomic<uint32_t> base_sleep_duration_{1}; // в микросекундах
+    // События медленного пути копятся в потоке и сбрасываются в Tuning
+    // пачками по LOCAL_FLUSH_EVENTS. У потока до LOCAL_BATCHES пачек для
+    // разных мьютексов (ключ - уникальный id, а не адрес); пачка
+    // отбрасывается, только если ее вытеснил мьютекс сверх этого числа
+    struct LocalEvents {
+        uint64_t owner_id = 0;
+        uint32_t slow = 0;
+        uint32_t spin = 0;
+        uint32_t park = 0;
+        uint32_t queued = 0;
+        uint64_t parks = 0;
+        uint64_t spins = 0;
+        uint64_t wait_ticks = 0;
+    };
     
-    // Для обновления параметров
-    mutable std::atomic<uint64_t> last_adaptation_time_{0};
+    static constexpr uint32_t LOCAL_FLUSH_EVENTS = 16;
+    static constexpr size_t LOCAL_BATCHES = 8;
     static constexpr uint64_t ADAPTATION_INTERVAL_NS = 1000000000; // 1 секунда
     
-    // Thread-local статистика
-    thread_local static uint64_t local_spin_count_;
+    // Пороги переключения режима (медленных захватов в секунду), разнесены,
+    // чтобы режим не дребезжал
+    static constexpr double QUEUE_ENTER_RATE = 20000.0;
+    static constexpr double QUEUE_LEAVE_RATE = 2000.0;
+    
+    // Горячая линия: слово блокировки и поля, которые трогает только владелец
+    // или которые не меняются после конструирования
+    std::atomic<uint32_t> state_{0};
+    uint64_t hold_start_ns_ = 0;             // пишет только владелец
+    std::unique_ptr<LockProfile> profile_;   // только для именованных мьютексов
+    const uint64_t id_ = next_mutex_id();    // ключ пачек LocalEvents
+    
+    alignas(CACHE_LINE_SIZE) std::atomic<QueueNode*> queue_tail_{nullptr};
+    
+    mutable Tuning tuning_;
+    
     thread_local static std::mt19937 rng_;
+    thread_local static std::array<LocalEvents, LOCAL_BATCHES> local_events_;
+    
+    static uint64_t next_mutex_id() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    
+    // Пачка этого мьютекса в потоке; если ее нет - свободная или самая
+    // маленькая чужая (ее события теряются)
+    LocalEvents& local_batch() const {
+        LocalEvents* victim = &local_events_[0];
+        for (LocalEvents& events : local_events_) {
+            if (events.owner_id == id_) {
+                return events;
+            }
+            if (events.slow < victim->slow) {
+                victim = &events;
+            }
+        }
+        *victim = LocalEvents{};
+        victim->owner_id = id_;
+        return *victim;
+    }
+    
+    static uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    // Вызывается после захвата: сэмплированная запись ожидания и начала удержания
+    void profile_acquired(uint64_t wait_ns, const std::source_location& location) {
+        if (profile_ && profile_->should_sample()) {
+            profile_->record_acquire(wait_ns, location);
+            hold_start_ns_ = now_ns();
+        }
+    }
+    
+    void note_slow_path(SlowPath path, uint64_t wait_ticks, uint64_t spins, uint64_t parks) const {
+        LocalEvents& events = local_batch();
+        
+        ++events.slow;
+        events.spin += path == SlowPath::Spin;
+        events.park += path == SlowPath::Park;
+        events.queued += path == SlowPath::Queue;
+        events.spins += spins;
+        events.parks += parks;
+        events.wait_ticks += wait_ticks;
+        
+        if (events.slow >= LOCAL_FLUSH_EVENTS) {
+            flush_local_events(events);
+            adapt_parameters();
+        }
+    }
+    
+    void flush_local_events(LocalEvents& events) const {
+        tuning_.slow_acquisitions.fetch_add(events.slow, std::memory_order_relaxed);
+        tuning_.spin_acquisitions.fetch_add(events.spin, std::memory_order_relaxed);
+        tuning_.sleep_acquisitions.fetch_add(events.park, std::memory_order_relaxed);
+        tuning_.queued_acquisitions.fetch_add(events.queued, std::memory_order_relaxed);
+        tuning_.total_spins.fetch_add(events.spins, std::memory_order_relaxed);
+        tuning_.total_parks.fetch_add(events.parks, std::memory_order_relaxed);
+        tuning_.contention_ticks.fetch_add(events.wait_ticks, std::memory_order_relaxed);
+        
+        tuning_.interval_slow.fetch_add(events.slow, std::memory_order_relaxed);
+        tuning_.interval_spin.fetch_add(events.spin, std::memory_order_relaxed);
+        tuning_.interval_park.fetch_add(events.park, std::memory_order_relaxed);
+        
+        events = LocalEvents{};
+        events.owner_id = id_;
+    }
     
     void adapt_parameters() const {
-        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
-        uint64_t last_time = last_adaptation_time_.load(std::memory_order_relaxed);
+        uint64_t now = adaptive_clock::ticks();
+        uint64_t last_time = tuning_.last_adaptation_ticks.load(std::memory_order_relaxed);
+        uint64_t interval_ticks = static_cast<uint64_t>(
+            ADAPTATION_INTERVAL_NS * adaptive_clock::ticks_per_ns());
         
-        if (now - last_time < ADAPTATION_INTERVAL_NS) {
+        if (now - last_time < interval_ticks) {
             return;
         }
         
-        if (!last_adaptation_time_.compare_exchange_weak(last_time, now, 
-                                                        std::memory_order_relaxed)) {
+        if (!tuning_.last_adaptation_ticks.compare_exchange_strong(last_time, now,
+                                                                   std::memory_order_relaxed)) {
             return; // Другой поток уже адаптирует
         }
         
-        uint64_t total = total_acquisitions_.load(std::memory_order_relaxed);
-        uint64_t spin_success = spin_acquisitions_.load(std::memory_order_relaxed);
-        uint64_t sleep_success = sleep_acquisitions_.load(std::memory_order_relaxed);
-        uint64_t avg_contention = total > 0 ? 
-            total_contention_time_.load(std::memory_order_relaxed) / total : 0;
-        
-        if (total < 100) {
-            return; // Недостаточно данных для адаптации
-        }
-        
-        // Адаптируем spin_limit
-        double spin_success_rate = static_cast<double>(spin_success) / total;
+        uint64_t slow = tuning_.interval_slow.exchange(0, std::memory_order_relaxed);
+        uint64_t spin_success = tuning_.interval_spin.exchange(0, std::memory_order_relaxed);
+        uint64_t park_success = tuning_.interval_park.exchange(0, std::memory_order_relaxed);
+        double seconds = last_time == 0 ? 1.0 :
+            adaptive_clock::to_ns(now - last_time) / 1e9;
         
-        if (spin_success_rate > 0.8) {
-            // Высокий успех при спине - можем увеличить лимит
-            uint32_t current_limit = spin_limit_.load(std::memory_order_relaxed);
-            uint32_t new_limit = std::min(current_limit * 2, 10000u);
-            spin_limit_.store(new_limit, std::memory_order_relaxed);
-        } else if (spin_success_rate < 0.3) {
-            // Низкий успех при спине - уменьшаем лимит
-            uint32_t current_limit = spin_limit_.load(std::memory_order_relaxed);
-            uint32_t new_limit = std::max(current_limit / 2, 100u);
-            spin_limit_.store(new_limit, std::memory_order_relaxed);
+        // Адаптируем spin_limit по доле TTAS-ожиданий, завершившихся спином
+        if (spin_success + park_success >= 100) {
+            double spin_success_rate = static_cast<double>(spin_success) /
+                                       (spin_success + park_success);
+            uint32_t current_limit = tuning_.spin_limit.load(std::memory_order_relaxed);
+            
+            if (spin_success_rate > 0.8) {
+                // Высокий успех при спине - можем увеличить лимит
+                tuning_.spin_limit.store(std::min(current_limit * 2, 10000u),
+                                         std::memory_order_relaxed);
+            } else if (spin_success_rate < 0.3) {
+                // Низкий успех при спине - уменьшаем лимит
+                tuning_.spin_limit.store(std::max(current_limit / 2, 100u),
+                                         std::memory_order_relaxed);
+            }
         }
         
-        // Адаптируем время сна
-        if (avg_contention > 100000) { // > 100 микросекунд
-            uint32_t current_sleep = base_sleep_duration_.load(std::memory_order_relaxed);
-            uint32_t new_sleep = std::min(current_sleep * 2, 1000u);
-            base_sleep_duration_.store(new_sleep, std::memory_order_relaxed);
-        } else if (avg_contention < 10000) { // < 10 микросекунд
-            uint32_t current_sleep = base_sleep_duration_.load(std::memory_order_relaxed);
-            uint32_t new_sleep = std::max(current_sleep / 2, 1u);
-            base_sleep_duration_.store(new_sleep, std::memory_order_relaxed);
+        // Выбираем режим: при частых медленных захватах TTAS-спин всех
+        // ожидающих по одному слову дает шторм кеш-линий и голодание
+        if (tuning_.mode_policy.load(std::memory_order_relaxed) == LockMode::Adaptive) {
+            double slow_rate = slow / seconds;
+            bool queued = tuning_.queued_mode.load(std::memory_order_relaxed);
+            
+            if (!queued && slow_rate > QUEUE_ENTER_RATE) {
+                tuning_.queued_mode.store(true, std::memory_order_relaxed);
+                tuning_.mode_switches.fetch_add(1, std::memory_order_relaxed);
+            } else if (queued && slow_rate < QUEUE_LEAVE_RATE) {
+                tuning_.queued_mode.store(false, std::memory_order_relaxed);
+                tuning_.mode_switches.fetch_add(1, std::memory_order_relaxed);
+            }
         }
-        
-        // Сбрасываем счетчики для следующего периода
-        total_acquisitions_.store(0, std::memory_order_relaxed);
-        spin_acquisitions_.store(0, std::memory_order_relaxed);
-        sleep_acquisitions_.store(0, std::memory_order_relaxed);
-        total_contention_time_.store(0, std::memory_order_relaxed);
     }
     
-    bool try_spin_lock() const {
-        uint32_t expected = static_cast<uint32_t>(State::UNLOCKED);
-        return state_.compare_exchange_weak(expected, static_cast<uint32_t>(State::LOCKED),
-                                          std::memory_order_acquire, 
-                                          std::memory_order_relaxed);
+    // Быстрый путь: свободен и очередь пуста
+    bool try_spin_lock() {
+        uint32_t expected = 0;
+        return state_.compare_exchange_strong(expected, LOCKED_BIT,
+                                            std::memory_order_acquire, 
+                                            std::memory_order_relaxed);
+    }
+    
+    // Захват, если LOCKED_BIT снят (остальные биты сохраняются)
+    bool try_acquire_bit(uint32_t extra_bits = 0) {
+        uint32_t current = state_.load(std::memory_order_relaxed);
+        return !(current & LOCKED_BIT) &&
+               state_.compare_exchange_weak(current, current | LOCKED_BIT | extra_bits,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed);
     }
     
     void exponential_backoff(uint32_t& backoff_count) const {
@@ -108,112 +563,228 @@ private:
         ++backoff_count;
     }
     
-public:
-    AdaptiveMutex() = default;
-    ~AdaptiveMutex() = default;
+    bool use_queue() const {
+        switch (tuning_.mode_policy.load(std::memory_order_relaxed)) {
+        case LockMode::Spin:
+            return false;
+        case LockMode::Queued:
+            return true;
+        default:
+            // Очередь уже непуста - встаем в нее, чтобы не обгонять ожидающих
+            return tuning_.queued_mode.load(std::memory_order_relaxed) ||
+                   (state_.load(std::memory_order_relaxed) & QUEUED_BIT);
+        }
+    }
     
-    AdaptiveMutex(const AdaptiveMutex&) = delete;
-    AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+    // Парковка на state_ (futex через atomic::wait). Захватываем с WAITERS_BIT:
+    // другие потоки тоже могут спать, и unlock() должен будет разбудить одного
+    uint64_t park_until_acquired() {
+        uint64_t parks = 0;
+        
+        while (true) {
+            uint32_t current = state_.load(std::memory_order_relaxed);
+            
+            if (!(current & LOCKED_BIT)) {
+                if (state_.compare_exchange_weak(current, current | LOCKED_BIT | WAITERS_BIT,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                    return parks;
+                }
+                continue;
+            }
+            
+            if (!(current & WAITERS_BIT) &&
+                !state_.compare_exchange_weak(current, current | WAITERS_BIT,
+                                              std::memory_order_relaxed)) {
+                continue;
+            }
+            
+            ++parks;
+            state_.wait(current | WAITERS_BIT, std::memory_order_relaxed);
+        }
+    }
     
-    void lock() {
-        auto start_time = std::chrono::high_resolution_clock::now();
+    // MCS: ждем своей очереди на собственной кеш-линии; по state_ спинит
+    // только голова очереди. Владение передается в порядке прихода.
+    // Узел - thread_local, а не на стеке: предшественник вызывает notify_one
+    // для is_head уже после того, как мы могли увидеть 1 и выйти. Поток
+    // стоит не больше чем в одной очереди, и после возврата на узел никто
+    // не ссылается, так что его можно переиспользовать
+    void lock_queued(uint64_t& spins, uint64_t& parks) {
+        thread_local QueueNode node;
+        node.next.store(nullptr, std::memory_order_relaxed);
+        node.is_head.store(0, std::memory_order_relaxed);
+        uint32_t spin_limit = tuning_.spin_limit.load(std::memory_order_relaxed);
         
-        // Фаза 1: Оптимистичная попытка без спина
-        if (try_spin_lock()) {
-            total_acquisitions_.fetch_add(1, std::memory_order_relaxed);
-            return;
+        QueueNode* predecessor = queue_tail_.exchange(&node, std::memory_order_acq_rel);
+        if (predecessor) {
+            predecessor->next.store(&node, std::memory_order_release);
+            adaptive_wait(node.is_head, 0, spin_limit);
         }
         
-        // Фаза 2: Адаптивный спин
+        // Голова очереди закрывает быстрый путь для новых потоков
+        state_.fetch_or(QUEUED_BIT, std::memory_order_relaxed);
+        
         uint32_t spin_count = 0;
-        uint32_t spin_limit = spin_limit_.load(std::memory_order_relaxed);
-        uint32_t backoff_count = 0;
+        while (!try_acquire_bit()) {
+            if (++spin_count >= spin_limit) {
+                parks += park_until_acquired();
+                break;
+            }
+            std::this_thread::yield();
+        }
+        spins += spin_count;
         
-        while (spin_count < spin_limit) {
-            // Проверяем состояние перед спином
-            uint32_t current_state = state_.load(std::memory_order_relaxed);
-            if (current_state == static_cast<uint32_t>(State::UNLOCKED)) {
-                if (try_spin_lock()) {
-                    auto end_time = std::chrono::high_resolution_clock::now();
-                    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                        end_time - start_time).count();
-                    
-                    total_acquisitions_.fetch_add(1, std::memory_order_relaxed);
-                    spin_acquisitions_.fetch_add(1, std::memory_order_relaxed);
-                    total_contention_time_.fetch_add(duration, std::memory_order_relaxed);
-                    
-                    // Периодически адаптируем параметры
-                    if ((total_acquisitions_.load() & 0xFF) == 0) {
-                        adapt_parameters();
-                    }
-                    
-                    return;
-                }
+        // Передаем положение головы следующему
+        QueueNode* successor = node.next.load(std::memory_order_acquire);
+        if (!successor) {
+            state_.fetch_and(~QUEUED_BIT, std::memory_order_relaxed);
+            
+            QueueNode* expected = &node;
+            if (queue_tail_.compare_exchange_strong(expected, nullptr,
+                                                    std::memory_order_acq_rel)) {
+                return; // очередь опустела
             }
             
-            exponential_backoff(backoff_count);
-            ++spin_count;
-            ++local_spin_count_;
+            // Кто-то уже встал за нами - дожидаемся, пока он привяжется
+            state_.fetch_or(QUEUED_BIT, std::memory_order_relaxed);
+            while (!(successor = node.next.load(std::memory_order_acquire))) {
+                std::this_thread::yield();
+            }
         }
         
-        // Фаза 3: Переходим к блокирующему ожиданию
-        uint32_t sleep_duration = base_sleep_duration_.load(std::memory_order_relaxed);
-        uint32_t sleep_backoff = 0;
+        successor->is_head.store(1, std::memory_order_release);
+        successor->is_head.notify_one();
+    }
+    
+    // Фаза 2 (TTAS): адаптивный спин с экспоненциальным backoff
+    bool spin_lock(uint64_t& spins) {
+        uint32_t spin_limit = tuning_.spin_limit.load(std::memory_order_relaxed);
+        uint32_t backoff_count = 0;
         
-        while (true) {
-            // Устанавливаем состояние "заблокирован с ожидающими"
-            uint32_t expected = static_cast<uint32_t>(State::UNLOCKED);
-            if (state_.compare_exchange_weak(expected, static_cast<uint32_t>(State::LOCKED),
-                                           std::memory_order_acquire,
-                                           std::memory_order_relaxed)) {
-                auto end_time = std::chrono::high_resolution_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    end_time - start_time).count();
-                
-                total_acquisitions_.fetch_add(1, std::memory_order_relaxed);
-                sleep_acquisitions_.fetch_add(1, std::memory_order_relaxed);
-                total_contention_time_.fetch_add(duration, std::memory_order_relaxed);
-                return;
+        for (uint32_t spin_count = 0; spin_count < spin_limit; ++spin_count) {
+            if (try_acquire_bit()) {
+                spins += spin_count;
+                return true;
             }
-            
-            // Помечаем, что есть ожидающие потоки
-            if (expected == static_cast<uint32_t>(State::LOCKED)) {
-                state_.compare_exchange_weak(expected, 
-                    static_cast<uint32_t>(State::LOCKED_WITH_WAITERS),
-                    std::memory_order_relaxed, std::memory_order_relaxed);
+            exponential_backoff(backoff_count);
+        }
+        spins += spin_limit;
+        return false;
+    }
+    
+    void lock_slow(const std::source_location& location) {
+        uint64_t start_ticks = adaptive_clock::ticks();
+        uint64_t spins = 0;
+        uint64_t parks = 0;
+        SlowPath path;
+        
+        if (use_queue()) {
+            // Фаза 2': Очередь MCS
+            lock_queued(spins, parks);
+            path = SlowPath::Queue;
+        } else if (spin_lock(spins)) {
+            // Фаза 2: Адаптивный спин
+            path = SlowPath::Spin;
+        } else {
+            // Фаза 3: Паркуемся на state_
+            parks = park_until_acquired();
+            path = SlowPath::Park;
+        }
+        
+        uint64_t wait_ticks = adaptive_clock::ticks() - start_ticks;
+        note_slow_path(path, wait_ticks, spins, parks);
+        if (profile_) {
+            profile_acquired(adaptive_clock::to_ns(wait_ticks), location);
+        }
+    }
+    
+    void unlock_slow() {
+        if (hold_start_ns_ != 0) {
+            profile_->record_hold(now_ns() - hold_start_ns_);
+            hold_start_ns_ = 0;
+        }
+        
+        // Снимаем LOCKED и WAITERS (QUEUED остается за очередью) и будим
+        // ровно одного ожидающего, если кто-то припаркован
+        uint32_t previous = state_.fetch_and(QUEUED_BIT, std::memory_order_release);
+        if (previous & WAITERS_BIT) {
+            state_.notify_one();
+        }
+    }
+    
+public:
+    // Калибровка TSC (2 мс) - здесь, а не при первой адаптации, которая
+    // выполняется уже под захваченным мьютексом
+    AdaptiveMutex() {
+        adaptive_clock::ticks_per_ns();
+    }
+    
+    // Именованный мьютекс с профилированием ожидания и удержания
+    explicit AdaptiveMutex(std::string name, uint32_t sample_period = 16)
+        : profile_(std::make_unique<LockProfile>(std::move(name), sample_period)) {
+        adaptive_clock::ticks_per_ns();
+        LockRegistry::instance().add(profile_.get());
+    }
+    
+    ~AdaptiveMutex() {
+        if (profile_) {
+            LockRegistry::instance().remove(profile_.get());
+        }
+    }
+    
+    AdaptiveMutex(const AdaptiveMutex&) = delete;
+    AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+    
+    void set_lock_mode(LockMode mode) {
+        tuning_.mode_policy.store(mode, std::memory_order_relaxed);
+        if (mode != LockMode::Adaptive) {
+            tuning_.queued_mode.store(mode == LockMode::Queued, std::memory_order_relaxed);
+        }
+    }
+    
+    // Быстрый путь - один CAS; часы, статистика и адаптация только на медленном
+    void lock(const std::source_location& location = std::source_location::current()) {
+        if (try_spin_lock()) [[likely]] {
+            if (profile_) [[unlikely]] {
+                profile_acquired(0, location);
             }
-            
-            // Спим с экспоненциальным увеличением времени
-            uint32_t actual_sleep = sleep_duration * (1 << std::min(sleep_backoff, 6u));
-            std::this_thread::sleep_for(std::chrono::microseconds(actual_sleep));
-            ++sleep_backoff;
+            return;
         }
+        lock_slow(location);
     }
     
-    bool try_lock() {
-        bool success = try_spin_lock();
-        if (success) {
-            total_acquisitions_.fetch_add(1, std::memory_order_relaxed);
+    bool try_lock(const std::source_location& location = std::source_location::current()) {
+        bool success = try_acquire_bit();
+        if (success && profile_) {
+            profile_acquired(0, location);
         }
         return success;
     }
     
     template<typename Rep, typename Period>
-    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
-        auto start_time = std::chrono::steady_clock::now();
-        auto timeout_point = start_time + timeout_duration;
-        
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration,
+                      const std::source_location& location = std::source_location::current()) {
         // Сначала пытаемся как обычный lock, но с ограничением по времени
-        if (try_spin_lock()) {
-            total_acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        if (try_acquire_bit()) {
+            if (profile_) {
+                profile_acquired(0, location);
+            }
             return true;
         }
         
+        auto start_time = std::chrono::steady_clock::now();
+        auto timeout_point = start_time + timeout_duration;
+        uint64_t start_ticks = adaptive_clock::ticks();
         uint32_t backoff_count = 0;
         
         while (std::chrono::steady_clock::now() < timeout_point) {
-            if (try_spin_lock()) {
-                total_acquisitions_.fetch_add(1, std::memory_order_relaxed);
+            if (try_acquire_bit()) {
+                uint64_t wait_ticks = adaptive_clock::ticks() - start_ticks;
+                note_slow_path(SlowPath::Spin, wait_ticks, backoff_count, 0);
+                if (profile_) {
+                    profile_acquired(adaptive_clock::to_ns(wait_ticks), location);
+                }
                 return true;
             }
             
@@ -224,67 +795,74 @@ public:
     }
     
     void unlock() {
-        uint32_t expected = static_cast<uint32_t>(State::LOCKED);
-        
-        // Простое освобождение если нет ожидающих
-        if (state_.compare_exchange_strong(expected, static_cast<uint32_t>(State::UNLOCKED),
-                                         std::memory_order_release,
-                                         std::memory_order_relaxed)) {
-            return;
-        }
-        
-        // Есть ожидающие потоки
-        expected = static_cast<uint32_t>(State::LOCKED_WITH_WAITERS);
-        if (state_.compare_exchange_strong(expected, static_cast<uint32_t>(State::UNLOCKED),
-                                         std::memory_order_release,
-                                         std::memory_order_relaxed)) {
-            // Можно уведомить ожидающие потоки, но в этой реализации
-            // они сами переопросят состояние
+        // Быстрый путь: нет профиля, ожидающих и очереди
+        uint32_t expected = LOCKED_BIT;
+        if (!profile_ && state_.compare_exchange_strong(expected, 0,
+                                                        std::memory_order_release,
+                                                        std::memory_order_relaxed)) [[likely]] {
             return;
         }
-        
-        // Состояние изменилось во время unlock - это не должно происходить
-        // В отладочной версии можно добавить assert
+        unlock_slow();
     }
     
-    // Статистика производительности
+    // Статистика производительности. Учитываются только захваты на
+    // медленном пути (быстрый путь ничего не считает), события сбрасываются
+    // из потоков пачками, поэтому значения приблизительные
     struct MutexStatistics {
-        uint64_t total_acquisitions;
+        uint64_t slow_acquisitions;
         uint64_t spin_acquisitions;
         uint64_t sleep_acquisitions;
+        uint64_t queued_acquisitions;
         uint64_t average_contention_time_ns;
         uint32_t current_spin_limit;
-        uint32_t current_sleep_duration;
-        uint64_t thread_local_spins;
+        uint64_t total_parks;
+        uint64_t total_spins;
+        bool queued_mode;
+        uint64_t mode_switches;
     };
     
+    // Текущий адаптивный лимит спина (используется производными примитивами)
+    uint32_t current_spin_limit() const {
+        return tuning_.spin_limit.load(std::memory_order_relaxed);
+    }
+    
     MutexStatistics get_statistics() const {
-        uint64_t total = total_acquisitions_.load(std::memory_order_relaxed);
-        uint64_t contention_time = total_contention_time_.load(std::memory_order_relaxed);
+        uint64_t slow = tuning_.slow_acquisitions.load(std::memory_order_relaxed);
+        uint64_t contention_ticks = tuning_.contention_ticks.load(std::memory_order_relaxed);
         
         return {
-            total,
-            spin_acquisitions_.load(std::memory_order_relaxed),
-            sleep_acquisitions_.load(std::memory_order_relaxed),
-            total > 0 ? contention_time / total : 0,
-            spin_limit_.load(std::memory_order_relaxed),
-            base_sleep_duration_.load(std::memory_order_relaxed),
-            local_spin_count_
+            slow,
+            tuning_.spin_acquisitions.load(std::memory_order_relaxed),
+            tuning_.sleep_acquisitions.load(std::memory_order_relaxed),
+            tuning_.queued_acquisitions.load(std::memory_order_relaxed),
+            slow > 0 ? adaptive_clock::to_ns(contention_ticks / slow) : 0,
+            tuning_.spin_limit.load(std::memory_order_relaxed),
+            tuning_.total_parks.load(std::memory_order_relaxed),
+            tuning_.total_spins.load(std::memory_order_relaxed),
+            tuning_.queued_mode.load(std::memory_order_relaxed),
+            tuning_.mode_switches.load(std::memory_order_relaxed)
         };
     }
     
     void reset_statistics() {
-        total_acquisitions_.store(0, std::memory_order_relaxed);
-        spin_acquisitions_.store(0, std::memory_order_relaxed);
-        sleep_acquisitions_.store(0, std::memory_order_relaxed);
-        total_contention_time_.store(0, std::memory_order_relaxed);
-        local_spin_count_ = 0;
+        tuning_.slow_acquisitions.store(0, std::memory_order_relaxed);
+        tuning_.spin_acquisitions.store(0, std::memory_order_relaxed);
+        tuning_.sleep_acquisitions.store(0, std::memory_order_relaxed);
+        tuning_.queued_acquisitions.store(0, std::memory_order_relaxed);
+        tuning_.total_parks.store(0, std::memory_order_relaxed);
+        tuning_.contention_ticks.store(0, std::memory_order_relaxed);
+        tuning_.total_spins.store(0, std::memory_order_relaxed);
+        tuning_.mode_switches.store(0, std::memory_order_relaxed);
+        if (profile_) {
+            profile_->reset();
+        }
     }
 };
 
 // Статические thread_local переменные
-thread_local uint64_t AdaptiveMutex::local_spin_count_ = 0;
 thread_local std::mt19937 AdaptiveMutex::rng_{std::random_device{}()};
+thread_local std::array<AdaptiveMutex::LocalEvents, AdaptiveMutex::LOCAL_BATCHES>
+    AdaptiveMutex::local_events_{};
 
 // RAII lock guard для AdaptiveMutex
 class AdaptiveLockGuard {
@@ -292,8 +870,10 @@ private:
     AdaptiveMutex& mutex_;
     
 public:
-    explicit AdaptiveLockGuard(AdaptiveMutex& mutex) : mutex_(mutex) {
-        mutex_.lock();
+    explicit AdaptiveLockGuard(AdaptiveMutex& mutex,
+                               const std::source_location& location = std::source_location::current())
+        : mutex_(mutex) {
+        mutex_.lock(location);
     }
     
     ~AdaptiveLockGuard() {
@@ -303,3 +883,544 @@ public:
     AdaptiveLockGuard(const AdaptiveLockGuard&) = delete;
     AdaptiveLockGuard& operator=(const AdaptiveLockGuard&) = delete;
 };
+
+// Reader-writer мьютекс с приоритетом писателя (big-reader lock).
+// У каждого потока свой счетчик читателей на отдельной кеш-линии, поэтому
+// lock_shared() не пишет в общие строки кеша. Писатель захватывает
+// AdaptiveMutex (спин/парковка и статистика оттуда), выставляет флаг и
+// дожидается обнуления всех счетчиков. Размер - около 4 КБ.
+class AdaptiveSharedMutex {
+private:
+    static constexpr size_t READER_SLOTS = 64;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    
+    struct alignas(CACHE_LINE_SIZE) ReaderSlot {
+        std::atomic<uint32_t> count{0};
+    };
+    
+    std::array<ReaderSlot, READER_SLOTS> readers_;
+    AdaptiveMutex writer_mutex_;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> writer_active_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> reader_backoffs_{0};
+    
+    // Слот закрепляется за потоком при первом обращении; при числе потоков
+    // больше READER_SLOTS счетчики делятся, оставаясь корректными
+    static ReaderSlot& slot_for_current_thread(std::array<ReaderSlot, READER_SLOTS>& readers) {
+        static std::atomic<size_t> next_slot{0};
+        thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+        return readers[slot];
+    }
+    
+public:
+    AdaptiveSharedMutex() = default;
+    
+    explicit AdaptiveSharedMutex(std::string name, uint32_t sample_period = 16)
+        : writer_mutex_(std::move(name), sample_period) {}
+    
+    AdaptiveSharedMutex(const AdaptiveSharedMutex&) = delete;
+    AdaptiveSharedMutex& operator=(const AdaptiveSharedMutex&) = delete;
+    
+    void lock(const std::source_location& location = std::source_location::current()) {
+        writer_mutex_.lock(location);
+        
+        // seq_cst в паре с lock_shared(): либо читатель видит флаг,
+        // либо писатель видит счетчик читателя
+        writer_active_.store(1, std::memory_order_seq_cst);
+        
+        uint32_t spin_limit = writer_mutex_.current_spin_limit();
+        for (auto& slot : readers_) {
+            uint32_t count;
+            while ((count = slot.count.load(std::memory_order_seq_cst)) != 0) {
+                adaptive_wait(slot.count, count, spin_limit);
+            }
+        }
+    }
+    
+    bool try_lock(const std::source_location& location = std::source_location::current()) {
+        if (!writer_mutex_.try_lock(location)) {
+            return false;
+        }
+        
+        writer_active_.store(1, std::memory_order_seq_cst);
+        for (auto& slot : readers_) {
+            if (slot.count.load(std::memory_order_seq_cst) != 0) {
+                unlock();
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    void unlock() {
+        writer_active_.store(0, std::memory_order_release);
+        writer_active_.notify_all();
+        writer_mutex_.unlock();
+    }
+    
+    void lock_shared() {
+        ReaderSlot& slot = slot_for_current_thread(readers_);
+        
+        while (true) {
+            slot.count.fetch_add(1, std::memory_order_seq_cst);
+            if (writer_active_.load(std::memory_order_seq_cst) == 0) {
+                return;
+            }
+            
+            // Приоритет писателя: отступаем и ждем его завершения
+            if (slot.count.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+                slot.count.notify_all();
+            }
+            reader_backoffs_.fetch_add(1, std::memory_order_relaxed);
+            adaptive_wait(writer_active_, 1, writer_mutex_.current_spin_limit());
+        }
+    }
+    
+    bool try_lock_shared() {
+        ReaderSlot& slot = slot_for_current_thread(readers_);
+        
+        slot.count.fetch_add(1, std::memory_order_seq_cst);
+        if (writer_active_.load(std::memory_order_seq_cst) == 0) {
+            return true;
+        }
+        if (slot.count.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+            slot.count.notify_all();
+        }
+        return false;
+    }
+    
+    void unlock_shared() {
+        ReaderSlot& slot = slot_for_current_thread(readers_);
+        
+        // Будим писателя, только если он ждет и это был последний читатель слота
+        if (slot.count.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+            writer_active_.load(std::memory_order_seq_cst) != 0) {
+            slot.count.notify_all();
+        }
+    }
+    
+    struct SharedMutexStatistics {
+        AdaptiveMutex::MutexStatistics writers;
+        uint64_t reader_backoffs;
+    };
+    
+    SharedMutexStatistics get_statistics() const {
+        return {
+            writer_mutex_.get_statistics(),
+            reader_backoffs_.load(std::memory_order_relaxed)
+        };
+    }
+    
+    void reset_statistics() {
+        writer_mutex_.reset_statistics();
+        reader_backoffs_.store(0, std::memory_order_relaxed);
+    }
+};
+
+// Sequence lock для маленьких, часто читаемых и редко изменяемых структур
+// (снимки конфигурации, таблицы маршрутизации). Читатель ничего не пишет в
+// общую память: копирует данные и проверяет, что версия не изменилась, иначе
+// повторяет. Писатели упорядочены AdaptiveMutex. Данные хранятся словами
+// std::atomic, поэтому гонки читателя с писателем нет и на уровне модели памяти
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock требует trivially copyable T");
+    
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    
+    // Нечетная версия - идет запись
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> sequence_{0};
+    std::array<std::atomic<uint64_t>, WORDS> words_{};
+    
+    AdaptiveMutex writer_mutex_;
+    alignas(CACHE_LINE_SIZE) mutable std::atomic<uint64_t> read_retries_{0};
+    
+    void load_words(std::array<uint64_t, WORDS>& buffer) const {
+        for (size_t i = 0; i < WORDS; ++i) {
+            buffer[i] = words_[i].load(std::memory_order_relaxed);
+        }
+    }
+    
+    void store_words(const T& value) {
+        std::array<uint64_t, WORDS> buffer{};
+        std::memcpy(buffer.data(), &value, sizeof(T));
+        for (size_t i = 0; i < WORDS; ++i) {
+            words_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+    }
+    
+    // Значение под захваченным writer_mutex_: версия стабильна
+    T load_locked() const {
+        std::array<uint64_t, WORDS> buffer;
+        load_words(buffer);
+        T value;
+        std::memcpy(&value, buffer.data(), sizeof(T));
+        return value;
+    }
+    
+public:
+    explicit SeqLock(const T& initial = T{}) {
+        store_words(initial);
+    }
+    
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+    
+    // Оптимистичное чтение: f получает согласованную копию и может
+    // вызываться только один раз, после успешной проверки версии
+    template<typename F>
+    auto read(F&& f) const -> std::invoke_result_t<F&, const T&> {
+        std::array<uint64_t, WORDS> buffer;
+        uint32_t retries = 0;
+        
+        while (true) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (!(before & 1)) {
+                load_words(buffer);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) == before) {
+                    break;
+                }
+            }
+            
+            // Запись короткая - уступаем процессор и повторяем
+            ++retries;
+            std::this_thread::yield();
+        }
+        
+        if (retries != 0) {
+            read_retries_.fetch_add(retries, std::memory_order_relaxed);
+        }
+        
+        T value;
+        std::memcpy(&value, buffer.data(), sizeof(T));
+        return f(static_cast<const T&>(value));
+    }
+    
+    T load() const {
+        return read([](const T& value) { return value; });
+    }
+    
+    // Изменение через f(T&). f выполняется над копией до открытия окна
+    // записи, поэтому читатели повторяют только на время копирования слов
+    template<typename F>
+    void write(F&& f, const std::source_location& location = std::source_location::current()) {
+        AdaptiveLockGuard lock(writer_mutex_, location);
+        
+        T value = load_locked();
+        f(value);
+        
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        store_words(value);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+    
+    void store(const T& value, const std::source_location& location = std::source_location::current()) {
+        write([&value](T& current) { current = value; }, location);
+    }
+    
+    struct SeqLockStatistics {
+        AdaptiveMutex::MutexStatistics writers;
+        uint64_t writes;
+        uint64_t read_retries;
+    };
+    
+    SeqLockStatistics get_statistics() const {
+        return {
+            writer_mutex_.get_statistics(),
+            sequence_.load(std::memory_order_relaxed) / 2,
+            read_retries_.load(std::memory_order_relaxed)
+        };
+    }
+};
+
+// Сравнение AdaptiveMutex и std::mutex: короткая критическая секция
+// под сильной конкуренцией, 2-64 потока
+namespace adaptive_mutex_benchmark
+{
+    template<typename Mutex>
+    double run(size_t num_threads, size_t iterations_per_thread) {
+        Mutex mutex;
+        uint64_t shared_counter = 0;
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                for (size_t i = 0; i < iterations_per_thread; ++i) {
+                    std::lock_guard<Mutex> lock(mutex);
+                    ++shared_counter;
+                }
+            });
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        
+        return num_threads * iterations_per_thread / seconds;
+    }
+    
+    inline void run_all(size_t iterations_per_thread = 100000) {
+        std::cout << "threads  std::mutex Mops/s  AdaptiveMutex Mops/s\n";
+        for (size_t threads : {2, 4, 8, 16, 32, 64}) {
+            double std_ops = run<std::mutex>(threads, iterations_per_thread);
+            double adaptive_ops = run<AdaptiveMutex>(threads, iterations_per_thread);
+            std::cout << std::setw(7) << threads
+                      << std::setw(19) << std::fixed << std::setprecision(2) << std_ops / 1e6
+                      << std::setw(22) << adaptive_ops / 1e6 << "\n";
+        }
+    }
+    
+    // Стоимость неконкурентной пары lock/unlock в одном потоке, нс/операция
+    template<typename Mutex>
+    double run_uncontended(size_t iterations = 10000000) {
+        Mutex mutex;
+        volatile uint64_t counter = 0;
+        
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            mutex.lock();
+            counter = counter + 1;
+            mutex.unlock();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+    
+    inline void run_uncontended_all(size_t iterations = 10000000) {
+        std::cout << "uncontended lock/unlock ns/op: std::mutex "
+                  << std::fixed << std::setprecision(2) << run_uncontended<std::mutex>(iterations)
+                  << ", AdaptiveMutex " << run_uncontended<AdaptiveMutex>(iterations) << "\n";
+    }
+    
+    // Read-mostly нагрузка: одна запись на write_every операций
+    template<typename SharedMutex>
+    double run_read_mostly(size_t num_threads, size_t iterations_per_thread,
+                           size_t write_every = 100) {
+        SharedMutex mutex;
+        std::array<uint64_t, 8> table{};
+        std::atomic<uint64_t> checksum{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t local = 0;
+                for (size_t i = 0; i < iterations_per_thread; ++i) {
+                    if ((i + t) % write_every == 0) {
+                        std::unique_lock<SharedMutex> lock(mutex);
+                        ++table[i % table.size()];
+                    } else {
+                        std::shared_lock<SharedMutex> lock(mutex);
+                        local += table[i % table.size()];
+                    }
+                }
+                checksum.fetch_add(local, std::memory_order_relaxed);
+            });
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        
+        return num_threads * iterations_per_thread / seconds;
+    }
+    
+    inline void run_shared_all(size_t iterations_per_thread = 100000) {
+        std::cout << "threads  std::shared_mutex Mops/s  AdaptiveSharedMutex Mops/s\n";
+        for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+            double std_ops = run_read_mostly<std::shared_mutex>(threads, iterations_per_thread);
+            double adaptive_ops = run_read_mostly<AdaptiveSharedMutex>(threads, iterations_per_thread);
+            std::cout << std::setw(7) << threads
+                      << std::setw(26) << std::fixed << std::setprecision(2) << std_ops / 1e6
+                      << std::setw(28) << adaptive_ops / 1e6 << "\n";
+        }
+    }
+    
+    // Снимок конфигурации для сравнения SeqLock с AdaptiveLockGuard
+    struct ConfigSnapshot {
+        uint64_t version;
+        uint64_t limits[6];
+        uint64_t checksum; // version + сумма limits, проверяется читателем
+    };
+    
+    inline void update_snapshot(ConfigSnapshot& snapshot) {
+        ++snapshot.version;
+        snapshot.checksum = snapshot.version;
+        for (size_t k = 0; k < 6; ++k) {
+            snapshot.limits[k] = snapshot.version * (k + 1);
+            snapshot.checksum += snapshot.limits[k];
+        }
+    }
+    
+    inline uint64_t snapshot_checksum(const ConfigSnapshot& snapshot) {
+        uint64_t sum = snapshot.version;
+        for (uint64_t limit : snapshot.limits) {
+            sum += limit;
+        }
+        return sum;
+    }
+    
+    // use_seqlock = false: то же самое под AdaptiveMutex + AdaptiveLockGuard.
+    // Возвращает операции в секунду; несогласованный снимок - исключение
+    inline double run_snapshot(bool use_seqlock, size_t num_threads,
+                               size_t iterations_per_thread, size_t write_every = 1000) {
+        SeqLock<ConfigSnapshot> seqlock;
+        AdaptiveMutex mutex;
+        ConfigSnapshot guarded{};
+        std::atomic<uint64_t> torn_reads{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t torn = 0;
+                for (size_t i = 0; i < iterations_per_thread; ++i) {
+                    bool write = (i + t) % write_every == 0;
+                    if (use_seqlock) {
+                        if (write) {
+                            seqlock.write(update_snapshot);
+                        } else {
+                            torn += seqlock.read([](const ConfigSnapshot& snapshot) {
+                                return snapshot_checksum(snapshot) != snapshot.checksum;
+                            });
+                        }
+                    } else {
+                        AdaptiveLockGuard lock(mutex);
+                        if (write) {
+                            update_snapshot(guarded);
+                        } else {
+                            torn += snapshot_checksum(guarded) != guarded.checksum;
+                        }
+                    }
+                }
+                torn_reads.fetch_add(torn, std::memory_order_relaxed);
+            });
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        if (torn_reads.load() != 0) {
+            throw std::runtime_error("SeqLock benchmark: несогласованный снимок");
+        }
+        return num_threads * iterations_per_thread / seconds;
+    }
+    
+    inline void run_snapshot_all(size_t iterations_per_thread = 100000) {
+        std::cout << "threads  AdaptiveLockGuard Mops/s  SeqLock Mops/s\n";
+        for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+            double guard_ops = run_snapshot(false, threads, iterations_per_thread);
+            double seqlock_ops = run_snapshot(true, threads, iterations_per_thread);
+            std::cout << std::setw(7) << threads
+                      << std::setw(26) << std::fixed << std::setprecision(2) << guard_ops / 1e6
+                      << std::setw(16) << seqlock_ops / 1e6 << "\n";
+        }
+    }
+    
+    struct TailLatencyResult {
+        double ops_per_second;
+        uint64_t wait_p50_ns;
+        uint64_t wait_p99_ns;
+        uint64_t wait_p999_ns;
+        uint64_t wait_max_ns;
+        double fairness; // min/max числа захватов по потокам, 1.0 - идеально
+    };
+    
+    // Хвост задержки захвата и справедливость за фиксированное время
+    template<typename Mutex>
+    TailLatencyResult run_tail_latency(Mutex& mutex, size_t num_threads,
+                                       std::chrono::milliseconds duration) {
+        LockHistogram waits;
+        std::vector<uint64_t> per_thread(num_threads, 0);
+        uint64_t shared_counter = 0;
+        std::atomic<bool> go{false};
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> threads;
+        
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t count = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto before = std::chrono::steady_clock::now();
+                    std::lock_guard<Mutex> lock(mutex);
+                    waits.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - before).count());
+                    ++shared_counter;
+                    ++count;
+                }
+                per_thread[t] = count;
+            });
+        }
+        
+        go.store(true, std::memory_order_release);
+        std::this_thread::sleep_for(duration);
+        stop.store(true, std::memory_order_relaxed);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        auto [min_it, max_it] = std::minmax_element(per_thread.begin(), per_thread.end());
+        return {
+            shared_counter / std::chrono::duration<double>(duration).count(),
+            waits.percentile(0.5),
+            waits.percentile(0.99),
+            waits.percentile(0.999),
+            waits.max(),
+            *max_it > 0 ? static_cast<double>(*min_it) / *max_it : 0.0
+        };
+    }
+    
+    inline void run_fairness_all(std::chrono::milliseconds duration = std::chrono::milliseconds(200)) {
+        auto print = [](const char* name, size_t threads, const TailLatencyResult& r) {
+            std::cout << std::setw(22) << name << std::setw(8) << threads
+                      << std::setw(10) << std::fixed << std::setprecision(2) << r.ops_per_second / 1e6
+                      << std::setw(12) << r.wait_p50_ns << std::setw(12) << r.wait_p99_ns
+                      << std::setw(12) << r.wait_p999_ns << std::setw(14) << r.wait_max_ns
+                      << std::setw(10) << r.fairness << "\n";
+        };
+        
+        std::cout << "                 mutex threads  Mops/s    p50 ns      p99 ns    p99.9 ns        max ns  fairness\n";
+        for (size_t threads : {4, 16, 64}) {
+            std::mutex std_mutex;
+            print("std::mutex", threads, run_tail_latency(std_mutex, threads, duration));
+            
+            AdaptiveMutex spin_mutex;
+            spin_mutex.set_lock_mode(AdaptiveMutex::LockMode::Spin);
+            print("AdaptiveMutex TTAS", threads, run_tail_latency(spin_mutex, threads, duration));
+            
+            AdaptiveMutex queued_mutex;
+            queued_mutex.set_lock_mode(AdaptiveMutex::LockMode::Queued);
+            print("AdaptiveMutex MCS", threads, run_tail_latency(queued_mutex, threads, duration));
+        }
+    }
+}
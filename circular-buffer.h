@@ -4,8 +4,25 @@
 
 #include <boost/circular_buffer.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <QDebug>
 
@@ -22,27 +39,132 @@ namespace circular_buffer
 
         }
 
-        void put(T item)
+        void put(const T& item)
         {
             std::lock_guard<std::mutex> lock(mutex_);
+            put_unlocked(item);
+        }
 
-            buf_[head_] = item;
+        void put(T&& item)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            put_unlocked(std::move(item));
+        }
+
+        // Like put, but refuses to overwrite when full
+        bool try_put(const T& item)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
 
             if(full_)
             {
-                tail_ = (tail_ + 1) % max_size_;
+                return false;
             }
 
-            head_ = (head_ + 1) % max_size_;
+            put_unlocked(item);
+            return true;
+        }
 
-            full_ = head_ == tail_;
+        bool try_put(T&& item)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if(full_)
+            {
+                return false;
+            }
+
+            put_unlocked(std::move(item));
+            return true;
+        }
+
+        // Copies as many items as fit without overwriting unread data and
+        // returns how many were written. At most two std::copy_n calls, which
+        // become memmove for trivially copyable T
+        size_t write(std::span<const T> items)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            size_t count = std::min(items.size(), max_size_ - size_unlocked());
+            size_t first = std::min(count, max_size_ - head_);
+
+            std::copy_n(items.begin(), first, buf_.get() + head_);
+            std::copy_n(items.begin() + first, count - first, buf_.get());
+
+            head_ = (head_ + count) % max_size_;
+            full_ = full_ || (count > 0 && head_ == tail_);
+
+            return count;
+        }
+
+        // Moves up to out.size() oldest items into out, returns how many
+        size_t read(std::span<T> out)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            size_t count = std::min(out.size(), size_unlocked());
+            size_t first = std::min(count, max_size_ - tail_);
+
+            std::move(buf_.get() + tail_, buf_.get() + tail_ + first, out.begin());
+            std::move(buf_.get(), buf_.get() + (count - first), out.begin() + first);
+
+            advance_tail(count);
+
+            return count;
+        }
+
+        bool try_get(T& out)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if(empty_unlocked())
+            {
+                return false;
+            }
+
+            out = std::move(buf_[tail_]);
+            advance_tail(1);
+
+            return true;
+        }
+
+        // Unread data as up to two contiguous spans, oldest first
+        struct ReadView
+        {
+            std::span<const T> first;
+            std::span<const T> second;
+
+            size_t size() const
+            {
+                return first.size() + second.size();
+            }
+        };
+
+        // Zero-copy access for the consumer; release the items with consume().
+        // The view stays valid while producers use write()/try_put(), which
+        // never overwrite unread data; put() may overwrite it
+        ReadView linear_read_view() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            size_t count = size_unlocked();
+            size_t first = std::min(count, max_size_ - tail_);
+
+            return {std::span<const T>(buf_.get() + tail_, first),
+                    std::span<const T>(buf_.get(), count - first)};
+        }
+
+        void consume(size_t count)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            advance_tail(std::min(count, size_unlocked()));
         }
 
         T get()
         {
             std::lock_guard<std::mutex> lock(mutex_);
 
-            if(empty())
+            if(empty_unlocked())
             {
                 return T();
             }
@@ -64,12 +186,13 @@ namespace circular_buffer
 
         bool empty() const
         {
-            //if head and tail are equal, we are empty
-            return (!full_ && (head_ == tail_));
+            std::lock_guard<std::mutex> lock(mutex_);
+            return empty_unlocked();
         }
 
         bool full() const
         {
+            std::lock_guard<std::mutex> lock(mutex_);
             //If tail is ahead the head by 1, we are full
             return full_;
         }
@@ -80,6 +203,37 @@ namespace circular_buffer
         }
 
         size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return size_unlocked();
+        }
+
+    private:
+        template <class U>
+        void put_unlocked(U&& item)
+        {
+            buf_[head_] = std::forward<U>(item);
+
+            if(full_)
+            {
+                tail_ = (tail_ + 1) % max_size_;
+            }
+
+            head_ = (head_ + 1) % max_size_;
+
+            full_ = head_ == tail_;
+        }
+
+        void advance_tail(size_t count)
+        {
+            if(count > 0)
+            {
+                tail_ = (tail_ + count) % max_size_;
+                full_ = false;
+            }
+        }
+
+        size_t size_unlocked() const
         {
             size_t size = max_size_;
 
@@ -98,8 +252,13 @@ namespace circular_buffer
             return size;
         }
 
-    private:
-        std::mutex mutex_;
+        bool empty_unlocked() const
+        {
+            //if head and tail are equal, we are empty
+            return (!full_ && (head_ == tail_));
+        }
+
+        mutable std::mutex mutex_;
         std::unique_ptr<T[]> buf_;
         size_t head_ = 0;
         size_t tail_ = 0;
@@ -107,6 +266,838 @@ namespace circular_buffer
         bool full_ = 0;
     };
 
+    // What a full ring does with a new element
+    enum class OverflowPolicy
+    {
+        Reject,         // try_put returns false
+        OverwriteOldest // put drops the oldest element, like CircularBuffer::put
+    };
+
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    inline size_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 1;
+        while(result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Lock-free ring for exactly one producer and one consumer thread.
+    // Capacity is rounded up to a power of two so positions are masked, not
+    // divided. head_ and tail_ live on separate cache lines and each side keeps
+    // a cached copy of the other's index, re-reading the shared one only when
+    // the ring looks full (producer) or empty (consumer).
+    //
+    // OverwriteOldest requires a trivially copyable T: the producer may
+    // overwrite a slot while the consumer copies it, so slots carry a version
+    // and the consumer validates its copy before claiming it with a CAS on tail_.
+    template <class T, OverflowPolicy Policy = OverflowPolicy::Reject>
+    class SpscRingBuffer
+    {
+        static constexpr bool OVERWRITE = Policy == OverflowPolicy::OverwriteOldest;
+        static_assert(!OVERWRITE || std::is_trivially_copyable_v<T>,
+                      "OverwriteOldest requires a trivially copyable T");
+
+        static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        struct RawSlot
+        {
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* ptr()
+            {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+        };
+
+        // version == 2 * position + 2 once the element at position is
+        // published, odd while it is being written
+        struct VersionedSlot
+        {
+            std::atomic<uint64_t> version{0};
+            std::array<std::atomic<uint64_t>, WORDS> words{};
+        };
+
+        using Slot = std::conditional_t<OVERWRITE, VersionedSlot, RawSlot>;
+
+    public:
+        explicit SpscRingBuffer(size_t size)
+            : capacity_(roundUpToPowerOfTwo(size)),
+            mask_(capacity_ - 1),
+            slots_(new Slot[capacity_])
+        {
+
+        }
+
+        ~SpscRingBuffer()
+        {
+            if constexpr(!OVERWRITE)
+            {
+                size_t head = head_.load(std::memory_order_relaxed);
+                for(size_t tail = tail_.load(std::memory_order_relaxed); tail != head; ++tail)
+                {
+                    slots_[tail & mask_].ptr()->~T();
+                }
+            }
+        }
+
+        SpscRingBuffer(const SpscRingBuffer&) = delete;
+        SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+        // Producer side, Reject policy
+        template <class... Args>
+        bool try_emplace(Args&&... args)
+        {
+            static_assert(!OVERWRITE, "use put() with OverwriteOldest");
+
+            size_t head = head_.load(std::memory_order_relaxed);
+            if(head - cached_tail_ == capacity_)
+            {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if(head - cached_tail_ == capacity_)
+                {
+                    return false;
+                }
+            }
+
+            new (slots_[head & mask_].storage) T(std::forward<Args>(args)...);
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_put(const T& item)
+        {
+            return try_emplace(item);
+        }
+
+        bool try_put(T&& item)
+        {
+            return try_emplace(std::move(item));
+        }
+
+        // Producer side, OverwriteOldest policy: never fails
+        void put(const T& item)
+        {
+            static_assert(OVERWRITE, "use try_put() with Reject");
+
+            size_t head = head_.load(std::memory_order_relaxed);
+            if(head - cached_tail_ >= capacity_)
+            {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                // A failed CAS means the consumer advanced tail_ and freed a slot
+                if(head - cached_tail_ >= capacity_ &&
+                   tail_.compare_exchange_strong(cached_tail_, cached_tail_ + 1,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+                {
+                    ++cached_tail_;
+                    overwritten_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            std::array<uint64_t, WORDS> buffer{};
+            std::memcpy(buffer.data(), &item, sizeof(T));
+
+            VersionedSlot& slot = slots_[head & mask_];
+            slot.version.store(2 * head + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for(size_t i = 0; i < WORDS; ++i)
+            {
+                slot.words[i].store(buffer[i], std::memory_order_relaxed);
+            }
+            slot.version.store(2 * head + 2, std::memory_order_release);
+
+            head_.store(head + 1, std::memory_order_release);
+        }
+
+        // Consumer side
+        bool try_get(T& out)
+        {
+            if constexpr(!OVERWRITE)
+            {
+                size_t tail = tail_.load(std::memory_order_relaxed);
+                if(!refresh_head(tail))
+                {
+                    return false;
+                }
+
+                T* item = slots_[tail & mask_].ptr();
+                out = std::move(*item);
+                item->~T();
+                tail_.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+            else
+            {
+                std::array<uint64_t, WORDS> buffer;
+
+                while(true)
+                {
+                    size_t tail = tail_.load(std::memory_order_acquire);
+                    if(!refresh_head(tail))
+                    {
+                        return false;
+                    }
+
+                    // Another version means the producer lapped us and already
+                    // moved tail_ forward: reload it
+                    VersionedSlot& slot = slots_[tail & mask_];
+                    uint64_t expected = 2 * tail + 2;
+                    if(slot.version.load(std::memory_order_acquire) != expected)
+                    {
+                        if(tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire))
+                        {
+                            return false;
+                        }
+                        continue;
+                    }
+
+                    for(size_t i = 0; i < WORDS; ++i)
+                    {
+                        buffer[i] = slot.words[i].load(std::memory_order_relaxed);
+                    }
+                    std::atomic_thread_fence(std::memory_order_acquire);
+
+                    if(slot.version.load(std::memory_order_relaxed) == expected &&
+                       tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel))
+                    {
+                        std::memcpy(&out, buffer.data(), sizeof(T));
+                        return true;
+                    }
+                }
+            }
+        }
+
+        // Approximate when called concurrently with put/get
+        size_t size() const
+        {
+            size_t tail = tail_.load(std::memory_order_acquire);
+            size_t head = head_.load(std::memory_order_acquire);
+            return head > tail ? head - tail : 0;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        bool full() const
+        {
+            return size() >= capacity_;
+        }
+
+        size_t capacity() const
+        {
+            return capacity_;
+        }
+
+        // Elements dropped by put() with OverwriteOldest
+        uint64_t overwritten() const
+        {
+            return overwritten_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // In overwrite mode put() may move tail_ past cached_head_, so any
+        // tail at or beyond the cached head means "maybe empty", not only ==
+        bool refresh_head(size_t tail)
+        {
+            if(static_cast<std::ptrdiff_t>(tail - cached_head_) >= 0)
+            {
+                cached_head_ = head_.load(std::memory_order_acquire);
+            }
+            return static_cast<std::ptrdiff_t>(cached_head_ - tail) > 0;
+        }
+
+        // Producer line
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+        size_t cached_tail_ = 0;
+        std::atomic<uint64_t> overwritten_{0};
+
+        // Consumer line
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+        size_t cached_head_ = 0;
+
+        alignas(CACHE_LINE_SIZE) const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+    };
+
+    // Bounded lock-free ring for many producers and one consumer. Producers
+    // claim a position with a CAS on head_; each slot carries a sequence number
+    // telling whether it is free for position pos (== pos) or holds its element
+    // (== pos + 1), so neither side ever reads the other's index. Full ring
+    // rejects the new element.
+    template <class T>
+    class MpscRingBuffer
+    {
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* ptr()
+            {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+        };
+
+    public:
+        explicit MpscRingBuffer(size_t size)
+            : capacity_(roundUpToPowerOfTwo(size)),
+            mask_(capacity_ - 1),
+            slots_(new Slot[capacity_])
+        {
+            for(size_t i = 0; i < capacity_; ++i)
+            {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~MpscRingBuffer()
+        {
+            T item;
+            while(try_get(item))
+            {
+            }
+        }
+
+        MpscRingBuffer(const MpscRingBuffer&) = delete;
+        MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+        template <class... Args>
+        bool try_emplace(Args&&... args)
+        {
+            size_t pos = head_.load(std::memory_order_relaxed);
+            Slot* slot;
+
+            while(true)
+            {
+                slot = &slots_[pos & mask_];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+                if(diff == 0)
+                {
+                    if(head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if(diff < 0)
+                {
+                    return false; // full: the consumer has not freed this slot yet
+                }
+                else
+                {
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            }
+
+            new (slot->storage) T(std::forward<Args>(args)...);
+            slot->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_put(const T& item)
+        {
+            return try_emplace(item);
+        }
+
+        bool try_put(T&& item)
+        {
+            return try_emplace(std::move(item));
+        }
+
+        // Consumer side: only one thread may call it
+        bool try_get(T& out)
+        {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            Slot& slot = slots_[pos & mask_];
+
+            if(slot.sequence.load(std::memory_order_acquire) != pos + 1)
+            {
+                return false;
+            }
+
+            T* item = slot.ptr();
+            out = std::move(*item);
+            item->~T();
+
+            slot.sequence.store(pos + capacity_, std::memory_order_release);
+            tail_.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Approximate when called concurrently with put/get
+        size_t size() const
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            size_t head = head_.load(std::memory_order_relaxed);
+            return head > tail ? head - tail : 0;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        size_t capacity() const
+        {
+            return capacity_;
+        }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+        alignas(CACHE_LINE_SIZE) const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+    };
+
+    // SPSC ring over a "magic" double mapping: the same memfd pages are
+    // mapped twice back to back, so the element after the last slot is the
+    // first slot again and any window of up to capacity() elements is
+    // contiguous. Producer and consumer work on spans in place
+    // (write_view/commit, read_view/consume) or copy with a single memcpy.
+    // Capacity is rounded up to whole pages, so T must be trivially copyable
+    template <class T>
+    class MagicRingBuffer
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "MagicRingBuffer requires a trivially copyable T");
+
+    public:
+        explicit MagicRingBuffer(size_t size)
+        {
+            size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            bytes_ = (size * sizeof(T) + page - 1) / page * page;
+            while(bytes_ == 0 || bytes_ % sizeof(T) != 0)
+            {
+                bytes_ += page;
+            }
+            capacity_ = bytes_ / sizeof(T);
+
+            int fd = ::memfd_create("magic_ring", MFD_CLOEXEC);
+            if(fd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "memfd_create");
+            }
+            if(::ftruncate(fd, static_cast<off_t>(bytes_)) != 0)
+            {
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "ftruncate");
+            }
+
+            // Reserve 2 * bytes_ of address space, then map the file over both halves
+            void* region = ::mmap(nullptr, 2 * bytes_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(region == MAP_FAILED)
+            {
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "mmap reserve");
+            }
+
+            char* base = static_cast<char*>(region);
+            for(char* half : {base, base + bytes_})
+            {
+                if(::mmap(half, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+                {
+                    int err = errno;
+                    ::munmap(region, 2 * bytes_);
+                    ::close(fd);
+                    throw std::system_error(err, std::generic_category(), "mmap");
+                }
+            }
+
+            // The mappings keep the file alive
+            ::close(fd);
+            data_ = reinterpret_cast<T*>(base);
+        }
+
+        ~MagicRingBuffer()
+        {
+            ::munmap(data_, 2 * bytes_);
+        }
+
+        MagicRingBuffer(const MagicRingBuffer&) = delete;
+        MagicRingBuffer& operator=(const MagicRingBuffer&) = delete;
+
+        // Producer: free space as one contiguous span, publish with commit()
+        std::span<T> write_view()
+        {
+            size_t head = head_.load(std::memory_order_relaxed);
+            size_t tail = tail_.load(std::memory_order_acquire);
+            return std::span<T>(data_ + head % capacity_, capacity_ - (head - tail));
+        }
+
+        void commit(size_t count)
+        {
+            head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        // Consumer: unread data as one contiguous span, release with consume()
+        std::span<const T> read_view()
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            size_t head = head_.load(std::memory_order_acquire);
+            return std::span<const T>(data_ + tail % capacity_, head - tail);
+        }
+
+        void consume(size_t count)
+        {
+            tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        // Copies as many items as fit, returns how many were written
+        size_t write(std::span<const T> items)
+        {
+            std::span<T> free_space = write_view();
+            size_t count = std::min(items.size(), free_space.size());
+            std::memcpy(free_space.data(), items.data(), count * sizeof(T));
+            commit(count);
+            return count;
+        }
+
+        size_t read(std::span<T> out)
+        {
+            std::span<const T> data = read_view();
+            size_t count = std::min(out.size(), data.size());
+            std::memcpy(out.data(), data.data(), count * sizeof(T));
+            consume(count);
+            return count;
+        }
+
+        // Approximate when called concurrently with the producer/consumer
+        size_t size() const
+        {
+            size_t tail = tail_.load(std::memory_order_acquire);
+            size_t head = head_.load(std::memory_order_acquire);
+            return head > tail ? head - tail : 0;
+        }
+
+        size_t capacity() const
+        {
+            return capacity_;
+        }
+
+    private:
+        // Views are taken per block, so the other side's index is always
+        // re-read instead of cached
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+
+        alignas(CACHE_LINE_SIZE) T* data_ = nullptr;
+        size_t bytes_ = 0;
+        size_t capacity_ = 0;
+    };
+
+    // Sliding window over the last max_samples samples and/or the samples not
+    // older than max_age. Aggregates are maintained on push and eviction, so
+    // every query is O(1): count, sum, mean and variance with a windowed
+    // Welford update, min and max with monotonic deques. push() is O(1)
+    // amortized. All methods lock an internal mutex; queries do not scan
+    template <class T, class Clock = std::chrono::steady_clock>
+    class WindowedRing
+    {
+        static_assert(std::is_arithmetic_v<T>, "WindowedRing requires an arithmetic T");
+
+    public:
+        using time_point = typename Clock::time_point;
+        using duration = typename Clock::duration;
+
+        struct Aggregates
+        {
+            size_t count = 0;
+            double sum = 0.0;
+            double mean = 0.0;
+            double variance = 0.0; // population variance of the window
+            T min = T();
+            T max = T();
+        };
+
+        // max_samples == 0 means no count limit (time window only)
+        explicit WindowedRing(size_t max_samples, duration max_age = duration::max())
+            : max_samples_(max_samples),
+            max_age_(max_age)
+        {
+
+        }
+
+        void push(T value, time_point now = Clock::now())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            uint64_t sequence = next_sequence_++;
+            samples_.push_back({sequence, now, value});
+
+            double x = static_cast<double>(value);
+            sum_ += x;
+            double delta = x - mean_;
+            mean_ += delta / samples_.size();
+            m2_ += delta * (x - mean_);
+
+            // Dominated candidates can never become the min/max again
+            while(!min_candidates_.empty() && min_candidates_.back().value >= value)
+            {
+                min_candidates_.pop_back();
+            }
+            min_candidates_.push_back({sequence, value});
+
+            while(!max_candidates_.empty() && max_candidates_.back().value <= value)
+            {
+                max_candidates_.pop_back();
+            }
+            max_candidates_.push_back({sequence, value});
+
+            if(max_samples_ != 0 && samples_.size() > max_samples_)
+            {
+                evict_front();
+            }
+            evict_expired(now);
+        }
+
+        // Evicts samples older than max_age relative to now, then returns all
+        // aggregates under a single lock
+        Aggregates snapshot(time_point now = Clock::now())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            evict_expired(now);
+
+            Aggregates result;
+            result.count = samples_.size();
+            if(result.count == 0)
+            {
+                return result;
+            }
+
+            result.sum = sum_;
+            result.mean = mean_;
+            result.variance = std::max(m2_ / result.count, 0.0);
+            result.min = min_candidates_.front().value;
+            result.max = max_candidates_.front().value;
+            return result;
+        }
+
+        void reset()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            samples_.clear();
+            min_candidates_.clear();
+            max_candidates_.clear();
+            sum_ = 0.0;
+            mean_ = 0.0;
+            m2_ = 0.0;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return samples_.size();
+        }
+
+    private:
+        struct Sample
+        {
+            uint64_t sequence;
+            time_point time;
+            T value;
+        };
+
+        struct Candidate
+        {
+            uint64_t sequence;
+            T value;
+        };
+
+        void evict_expired(time_point now)
+        {
+            if(max_age_ == duration::max())
+            {
+                return;
+            }
+
+            while(!samples_.empty() && now - samples_.front().time > max_age_)
+            {
+                evict_front();
+            }
+        }
+
+        void evict_front()
+        {
+            const Sample& oldest = samples_.front();
+
+            if(min_candidates_.front().sequence == oldest.sequence)
+            {
+                min_candidates_.pop_front();
+            }
+            if(max_candidates_.front().sequence == oldest.sequence)
+            {
+                max_candidates_.pop_front();
+            }
+
+            double x = static_cast<double>(oldest.value);
+            samples_.pop_front();
+            sum_ -= x;
+
+            if(samples_.empty())
+            {
+                // Restart from exact zero so rounding errors do not accumulate
+                sum_ = 0.0;
+                mean_ = 0.0;
+                m2_ = 0.0;
+                return;
+            }
+
+            double delta = x - mean_;
+            mean_ -= delta / samples_.size();
+            m2_ -= delta * (x - mean_);
+        }
+
+        mutable std::mutex mutex_;
+        std::deque<Sample> samples_;
+        std::deque<Candidate> min_candidates_;
+        std::deque<Candidate> max_candidates_;
+        uint64_t next_sequence_ = 0;
+        double sum_ = 0.0;
+        double mean_ = 0.0;
+        double m2_ = 0.0;
+        const size_t max_samples_;
+        const duration max_age_;
+    };
+
+    // Ring buffer throughput: producers push items_per_producer values each,
+    // one consumer drains them. put/get return false on full/empty and are
+    // retried. Returns items per second, or 0 if the checksum does not match
+    template <class Put, class Get>
+    double benchmarkRing(size_t producers, size_t items_per_producer, Put put, Get get)
+    {
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+
+        for(size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]()
+            {
+                while(!go.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                for(uint64_t i = 0; i < items_per_producer; ++i)
+                {
+                    while(!put(p * items_per_producer + i))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        uint64_t total = producers * items_per_producer;
+        uint64_t expected_sum = total * (total - 1) / 2;
+        uint64_t sum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+
+        for(uint64_t received = 0; received < total;)
+        {
+            uint64_t value;
+            if(get(value))
+            {
+                sum += value;
+                ++received;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        return sum == expected_sum ? total / seconds : 0.0;
+    }
+
+    inline void benchmarkRings(size_t items_per_producer = 1000000, size_t size = 1024)
+    {
+        qDebug() << "\n === Ring buffer throughput, Mitems/s ===\n";
+
+        for(size_t producers : {1, 2, 4, 8})
+        {
+            CircularBuffer<uint64_t> mutex_ring(size);
+            double mutex_rate = benchmarkRing(producers, items_per_producer,
+                [&](uint64_t value) { return mutex_ring.try_put(value); },
+                [&](uint64_t& value)
+                {
+                    if(mutex_ring.empty())
+                    {
+                        return false;
+                    }
+                    value = mutex_ring.get();
+                    return true;
+                });
+
+            std::mutex boost_mutex;
+            boost::circular_buffer<uint64_t> boost_ring(size);
+            double boost_rate = benchmarkRing(producers, items_per_producer,
+                [&](uint64_t value)
+                {
+                    std::lock_guard<std::mutex> lock(boost_mutex);
+                    if(boost_ring.full())
+                    {
+                        return false;
+                    }
+                    boost_ring.push_back(value);
+                    return true;
+                },
+                [&](uint64_t& value)
+                {
+                    std::lock_guard<std::mutex> lock(boost_mutex);
+                    if(boost_ring.empty())
+                    {
+                        return false;
+                    }
+                    value = boost_ring.front();
+                    boost_ring.pop_front();
+                    return true;
+                });
+
+            MpscRingBuffer<uint64_t> mpsc_ring(size);
+            double mpsc_rate = benchmarkRing(producers, items_per_producer,
+                [&](uint64_t value) { return mpsc_ring.try_put(value); },
+                [&](uint64_t& value) { return mpsc_ring.try_get(value); });
+
+            if(producers == 1)
+            {
+                SpscRingBuffer<uint64_t> spsc_ring(size);
+                double spsc_rate = benchmarkRing(producers, items_per_producer,
+                    [&](uint64_t value) { return spsc_ring.try_put(value); },
+                    [&](uint64_t& value) { return spsc_ring.try_get(value); });
+
+                qDebug() << "producers: 1"
+                         << "CircularBuffer:" << mutex_rate / 1e6
+                         << "boost+mutex:" << boost_rate / 1e6
+                         << "SpscRingBuffer:" << spsc_rate / 1e6
+                         << "MpscRingBuffer:" << mpsc_rate / 1e6;
+            }
+            else
+            {
+                qDebug() << "producers:" << producers
+                         << "CircularBuffer:" << mutex_rate / 1e6
+                         << "boost+mutex:" << boost_rate / 1e6
+                         << "MpscRingBuffer:" << mpsc_rate / 1e6;
+            }
+        }
+    }
+
     void testNative()
     {
         CircularBuffer<uint32_t> circle(10);
@@ -166,6 +1157,58 @@ namespace circular_buffer
         qDebug() << "Full: " << circle.full();
     }
 
+    void testBulk()
+    {
+        qDebug() << "\n === Bulk read/write check ===\n";
+
+        CircularBuffer<uint32_t> circle(8);
+        std::vector<uint32_t> frame = {1, 2, 3, 4, 5, 6};
+        std::vector<uint32_t> out(8);
+
+        qDebug() << "Written: " << circle.write(frame);
+        qDebug() << "Read: " << circle.read(std::span<uint32_t>(out.data(), 4));
+        qDebug() << "Written across the end: " << circle.write(frame);
+
+        auto view = circle.linear_read_view();
+        qDebug() << "View: " << view.first.size() << "+" << view.second.size() << "items";
+        circle.consume(view.size());
+        qDebug() << "Empty: " << circle.empty();
+
+        MagicRingBuffer<uint32_t> magic(1000);
+        qDebug() << "Magic ring capacity: " << magic.capacity();
+        std::vector<uint32_t> block(magic.capacity() - 3, 7);
+        magic.write(block);
+        magic.read(std::span<uint32_t>(block.data(), block.size() - 5));
+        magic.write(std::span<const uint32_t>(block.data(), 10));
+        qDebug() << "Contiguous window across the end: " << magic.read_view().size() << "items";
+    }
+
+    void testWindowed()
+    {
+        qDebug() << "\n === Windowed aggregates check ===\n";
+
+        WindowedRing<double> last_five(5);
+        for(double x : {4.0, 8.0, 1.0, 9.0, 3.0, 7.0, 2.0})
+        {
+            last_five.push(x);
+        }
+
+        auto stats = last_five.snapshot();
+        qDebug() << "Last 5: count" << stats.count << "mean" << stats.mean
+                 << "variance" << stats.variance << "min" << stats.min << "max" << stats.max;
+
+        using namespace std::chrono_literals;
+        auto start = std::chrono::steady_clock::now();
+        WindowedRing<uint32_t> last_ten_seconds(0, 10s);
+        for(uint32_t second = 0; second < 30; ++second)
+        {
+            last_ten_seconds.push(second, start + std::chrono::seconds(second));
+        }
+
+        auto recent = last_ten_seconds.snapshot(start + 29s);
+        qDebug() << "Last 10 s: count" << recent.count << "min" << recent.min << "max" << recent.max;
+    }
+
     void testBoost()
     {
         // Create a circular buffer with a capacity for 3 integers.
@@ -202,6 +1245,8 @@ namespace circular_buffer
     void test()
     {
         testNative();
+        testBulk();
+        testWindowed();
         testBoost();
     }
 }
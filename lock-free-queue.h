@@ -0,0 +1,259 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "memory-reclamation.h"
+
+// Неограниченная lock-free очередь Майкла-Скотта (MPMC, строгий FIFO).
+// Голова всегда указывает на фиктивный узел, значение лежит в следующем за
+// ним. Узлы освобождаются через ту же схему Reclaimer, что и у LockFreeStack,
+// память узлов - из reclamation::NodePool (Pooled = false - обычная куча)
+template<typename T, typename Reclaimer = reclamation::HazardPointers, bool Pooled = true>
+class LockFreeQueue {
+private:
+    // Значение конструируется только в узлах с данными; фиктивный узел
+    // и узел, из которого значение уже забрали, хранят пустое место
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    using Allocator = std::conditional_t<Pooled, reclamation::NodePool<Node>, reclamation::HeapNodes<Node>>;
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> head_;
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> tail_;
+
+    static Node* make_dummy() {
+        return new (Allocator::allocate()) Node;
+    }
+
+    template<typename... Args>
+    static Node* make_node(Args&&... args) {
+        Node* node = make_dummy();
+        try {
+            new (node->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            destroy_node(node);
+            throw;
+        }
+        return node;
+    }
+
+    // Значение к этому моменту уже разрушено (или его не было)
+    static void destroy_node(void* pointer) {
+        static_cast<Node*>(pointer)->~Node();
+        Allocator::deallocate(pointer);
+    }
+
+    void enqueue_node(Node* node) {
+        typename Reclaimer::Guard guard;
+
+        while (true) {
+            Node* tail = guard.protect(tail_);
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (tail != tail_.load(std::memory_order_acquire)) {
+                continue;
+            }
+
+            // tail отстал - помогаем его продвинуть
+            if (next) {
+                tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                            std::memory_order_relaxed);
+                continue;
+            }
+
+            Node* expected = nullptr;
+            if (tail->next.compare_exchange_weak(expected, node, std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+                tail_.compare_exchange_strong(tail, node, std::memory_order_release,
+                                              std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+public:
+    LockFreeQueue() {
+        Node* dummy = make_dummy();
+        head_.store(dummy, std::memory_order_relaxed);
+        tail_.store(dummy, std::memory_order_relaxed);
+    }
+
+    ~LockFreeQueue() {
+        Node* node = head_.load(std::memory_order_relaxed);
+        Node* next = node->next.load(std::memory_order_relaxed);
+        destroy_node(node);
+
+        while (next) {
+            node = next;
+            next = node->next.load(std::memory_order_relaxed);
+            node->value()->~T();
+            destroy_node(node);
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        enqueue_node(make_node(std::forward<Args>(args)...));
+    }
+
+    void enqueue(const T& item) {
+        emplace(item);
+    }
+
+    void enqueue(T&& item) {
+        emplace(std::move(item));
+    }
+
+    bool try_dequeue(T& out) {
+        typename Reclaimer::Guard head_guard;
+        typename Reclaimer::Guard next_guard;
+
+        while (true) {
+            Node* head = head_guard.protect(head_);
+            Node* next = next_guard.protect(head->next);
+
+            // Голова не сменилась - значит, next еще достижим и защищен вовремя
+            if (head != head_.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if (!next) {
+                return false;
+            }
+
+            Node* tail = tail_.load(std::memory_order_acquire);
+            if (head == tail) {
+                tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                            std::memory_order_relaxed);
+                continue;
+            }
+
+            if (head_.compare_exchange_weak(head, next, std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                // Значение в next принадлежит только нам; next становится
+                // новым фиктивным узлом, остальные потоки читают лишь его next
+                T* value = next->value();
+                out = std::move(*value);
+                value->~T();
+
+                head_guard.reset();
+                next_guard.reset();
+                Reclaimer::retire(head, &destroy_node);
+                return true;
+            }
+        }
+    }
+
+    bool empty() const {
+        typename Reclaimer::Guard guard;
+        Node* head = guard.protect(head_);
+        return head->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // Обращения к куче за узлами для всех очередей с этими T и Pooled
+    static uint64_t heap_allocations() {
+        return Allocator::heap_allocations();
+    }
+};
+
+// LockFreeQueue против std::mutex + std::deque: N производителей и
+// N потребителей, проверка суммы
+namespace lock_free_queue_benchmark
+{
+    class MutexDequeQueue {
+    private:
+        std::mutex mutex_;
+        std::deque<uint64_t> items_;
+
+    public:
+        void enqueue(uint64_t item) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            items_.push_back(item);
+        }
+
+        bool try_dequeue(uint64_t& out) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (items_.empty()) {
+                return false;
+            }
+            out = items_.front();
+            items_.pop_front();
+            return true;
+        }
+    };
+
+    template<typename Queue>
+    double run(size_t pairs, size_t items_per_producer) {
+        Queue queue;
+        std::atomic<bool> go{false};
+        std::atomic<uint64_t> consumed{0};
+        std::atomic<uint64_t> sum{0};
+        std::vector<std::thread> threads;
+        uint64_t total = pairs * items_per_producer;
+
+        for (size_t p = 0; p < pairs; ++p) {
+            threads.emplace_back([&]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                for (uint64_t i = 1; i <= items_per_producer; ++i) {
+                    queue.enqueue(i);
+                }
+            });
+            threads.emplace_back([&]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t local_sum = 0;
+                uint64_t value;
+                while (consumed.load(std::memory_order_relaxed) < total) {
+                    if (queue.try_dequeue(value)) {
+                        local_sum += value;
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                sum.fetch_add(local_sum, std::memory_order_relaxed);
+            });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t expected = pairs * (items_per_producer * (items_per_producer + 1) / 2);
+        return sum.load() == expected ? total / seconds : 0.0;
+    }
+
+    inline void run_all(size_t items_per_producer = 200000) {
+        std::cout << "producers+consumers  mutex+deque Mitems/s  LockFreeQueue Mitems/s\n";
+        for (size_t pairs : {1, 2, 4, 8, 16, 32}) {
+            double mutex_rate = run<MutexDequeQueue>(pairs, items_per_producer);
+            double lock_free_rate = run<LockFreeQueue<uint64_t>>(pairs, items_per_producer);
+            std::cout << std::setw(10) << pairs << "+" << std::left << std::setw(9) << pairs << std::right
+                      << std::setw(22) << std::fixed << std::setprecision(2) << mutex_rate / 1e6
+                      << std::setw(24) << lock_free_rate / 1e6 << "\n";
+        }
+    }
+}
@@ -2,70 +2,203 @@
 #include <memory>
 #include <thread>
 #include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
-template<typename T>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "memory-reclamation.h"
+
+// Стек Трайбера. Узлы, снятые pop(), освобождаются через схему Reclaimer
+// (reclamation::HazardPointers или reclamation::EpochReclamation), поэтому
+// pop() не обращается к освобожденной памяти и не страдает от ABA.
+// Значение хранится прямо в узле (одно выделение на элемент), а память узлов
+// берется из reclamation::NodePool; Pooled = false - обычная куча.
+//
+// Под конкуренцией повторно неудачный CAS на head (ELIMINATION_CAS_FAILURES
+// подряд) уводит поток в массив элиминации: push выставляет узел в
+// случайный слот и недолго крутится на pause, pop забирает
+// выставленный узел - пара завершается, не трогая head. Такой узел никогда
+// не был в стеке, поэтому освобождается сразу, без Reclaimer
+template<typename T, typename Reclaimer = reclamation::HazardPointers, bool Pooled = true>
 class LockFreeStack {
 private:
     struct Node {
-        std::atomic<T*> data;
-        std::atomic<Node*> next;
+        std::atomic<Node*> next{nullptr};
+        T value;
         
-        Node() : data(nullptr), next(nullptr) {}
+        template<typename... Args>
+        explicit Node(Args&&... args) : value(std::forward<Args>(args)...) {}
     };
     
-    std::atomic<Node*> head;
+    using Allocator = std::conditional_t<Pooled, reclamation::NodePool<Node>, reclamation::HeapNodes<Node>>;
     
-    // Hazard Pointer для защиты от ABA проблемы
-    static constexpr int MAX_THREADS = 100;
-    struct HazardPointer {
-        std::atomic<std::thread::id> id;
-        std::atomic<Node*> pointer;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t ELIMINATION_SLOTS = 8;
+    static constexpr uint32_t ELIMINATION_SPINS = 32;
+    static constexpr uint32_t ELIMINATION_CAS_FAILURES = 4;
+    
+    // nullptr - пусто, Node* - предложение push, taken_marker() - забран pop
+    struct alignas(CACHE_LINE_SIZE) EliminationSlot {
+        std::atomic<void*> offer{nullptr};
     };
     
-    static std::array<HazardPointer, MAX_THREADS> hazard_pointers;
-    static std::atomic<Node*> to_be_deleted;
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> head;
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> elimination_enabled_{true};
+    std::atomic<uint64_t> eliminations_{0};
+    std::array<EliminationSlot, ELIMINATION_SLOTS> elimination_;
+    
+    static void destroy_node(void* pointer) {
+        static_cast<Node*>(pointer)->~Node();
+        Allocator::deallocate(pointer);
+    }
+    
+    template<typename... Args>
+    static Node* make_node(Args&&... args) {
+        void* memory = Allocator::allocate();
+        try {
+            return new (memory) Node(std::forward<Args>(args)...);
+        } catch (...) {
+            Allocator::deallocate(memory);
+            throw;
+        }
+    }
+    
+    static void* taken_marker() {
+        static char marker;
+        return &marker;
+    }
     
-    static HazardPointer* get_hazard_pointer_for_current_thread() {
-        thread_local static HazardPointer* hp = nullptr;
+    static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+    
+    static size_t random_slot() {
+        thread_local uint32_t state =
+            static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % ELIMINATION_SLOTS;
+    }
+    
+    bool try_eliminate_push(Node* node) {
+        EliminationSlot& slot = elimination_[random_slot()];
+        void* expected = nullptr;
+        if (!slot.offer.compare_exchange_strong(expected, node, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+            return false;
+        }
         
-        if (!hp) {
-            auto thread_id = std::this_thread::get_id();
-            for (auto& hazard : hazard_pointers) {
-                std::thread::id default_id;
-                if (hazard.id.compare_exchange_strong(default_id, thread_id)) {
-                    hp = &hazard;
-                    break;
-                }
+        for (uint32_t i = 0; i < ELIMINATION_SPINS; ++i) {
+            if (slot.offer.load(std::memory_order_acquire) != node) {
+                break;
             }
+            cpu_relax();
+        }
+        
+        // Отзываем предложение; не вышло - значит, pop уже забрал узел
+        expected = node;
+        if (slot.offer.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed)) {
+            return false;
         }
-        return hp;
+        
+        slot.offer.store(nullptr, std::memory_order_release);
+        eliminations_.fetch_add(1, std::memory_order_relaxed);
+        return true;
     }
     
-    static bool is_pointer_hazardous(Node* ptr) {
-        for (const auto& hazard : hazard_pointers) {
-            if (hazard.pointer.load() == ptr) {
-                return true;
+    Node* try_eliminate_pop() {
+        EliminationSlot& slot = elimination_[random_slot()];
+        void* offer = slot.offer.load(std::memory_order_acquire);
+        if (!offer || offer == taken_marker()) {
+            return nullptr;
+        }
+        
+        if (!slot.offer.compare_exchange_strong(offer, taken_marker(), std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return static_cast<Node*>(offer);
+    }
+    
+    // Без встречных pop элиминация - чистое ожидание, поэтому в массив идем
+    // только после нескольких неудачных CAS подряд, а между ними - pause
+    void push_node(Node* new_node) {
+        Node* current_head = head.load(std::memory_order_relaxed);
+        uint32_t failures = 0;
+        while (true) {
+            new_node->next.store(current_head, std::memory_order_relaxed);
+            if (head.compare_exchange_weak(current_head, new_node,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+                return;
+            }
+            if (++failures < ELIMINATION_CAS_FAILURES) {
+                cpu_relax();
+                continue;
+            }
+            failures = 0;
+            if (elimination_enabled_.load(std::memory_order_relaxed) && try_eliminate_push(new_node)) {
+                return;
             }
         }
-        return false;
     }
     
-    static void delete_nodes_no_hazards() {
-        Node* current = to_be_deleted.exchange(nullptr);
+    // Вклеивает готовую цепочку top..bottom одним CAS
+    void splice(Node* top, Node* bottom) {
+        Node* current_head = head.load(std::memory_order_relaxed);
+        do {
+            bottom->next.store(current_head, std::memory_order_relaxed);
+        } while (!head.compare_exchange_weak(current_head, top,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+    
+    // Снимает вершину; значение остается в узле. eliminated - узел получен
+    // из массива элиминации и в стеке не был: его можно освободить сразу
+    Node* pop_node(typename Reclaimer::Guard& guard, bool& eliminated) {
+        eliminated = false;
         
-        while (current) {
-            Node* next = current->next.load();
-            
-            if (!is_pointer_hazardous(current)) {
-                delete current->data.load();
-                delete current;
-            } else {
-                // Возвращаем в список на удаление
-                current->next.store(to_be_deleted.load());
-                while (!to_be_deleted.compare_exchange_weak(current->next.load(), current));
+        while (true) {
+            // После неудачного CAS новую вершину нужно снова защитить
+            Node* old_head = guard.protect(head);
+            if (!old_head) {
+                return nullptr;
             }
-            
-            current = next;
+            if (head.compare_exchange_weak(old_head, old_head->next.load(std::memory_order_relaxed),
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed)) {
+                return old_head;
+            }
+            if (elimination_enabled_.load(std::memory_order_relaxed)) {
+                if (Node* node = try_eliminate_pop()) {
+                    eliminated = true;
+                    return node;
+                }
+            }
+        }
+    }
+    
+    void release_popped(typename Reclaimer::Guard& guard, Node* node, bool eliminated) {
+        guard.reset();
+        if (eliminated) {
+            destroy_node(node);
+        } else {
+            Reclaimer::retire(node, &destroy_node);
         }
     }
     
@@ -73,80 +206,410 @@ public:
     LockFreeStack() : head(nullptr) {}
     
     ~LockFreeStack() {
-        while (Node* old_head = head.load()) {
-            head.store(old_head->next.load());
-            delete old_head->data.load();
-            delete old_head;
+        Node* node = head.load();
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            destroy_node(node);
+            node = next;
         }
-        
-        // Очищаем список отложенного удаления
-        delete_nodes_no_hazards();
     }
     
-    void push(T item) {
-        Node* new_node = new Node;
-        T* data = new T(std::move(item));
-        new_node->data.store(data);
-        
-        Node* current_head = head.load();
-        do {
-            new_node->next.store(current_head);
-        } while (!head.compare_exchange_weak(current_head, new_node));
+    LockFreeStack(const LockFreeStack&) = delete;
+    LockFreeStack& operator=(const LockFreeStack&) = delete;
+    
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        push_node(make_node(std::forward<Args>(args)...));
     }
     
-    std::unique_ptr<T> pop() {
-        HazardPointer* hp = get_hazard_pointer_for_current_thread();
-        if (!hp) {
-            return nullptr; // Нет доступных hazard pointers
+    void push(const T& item) {
+        emplace(item);
+    }
+    
+    void push(T&& item) {
+        emplace(std::move(item));
+    }
+    
+    // Элементы [first, last) одним CAS; last - 1 окажется на вершине,
+    // как после последовательных push
+    template<typename InputIt>
+    void push_bulk(InputIt first, InputIt last) {
+        Node* top = nullptr;
+        Node* bottom = nullptr;
+        
+        try {
+            for (; first != last; ++first) {
+                Node* node = make_node(*first);
+                node->next.store(top, std::memory_order_relaxed);
+                top = node;
+                if (!bottom) {
+                    bottom = node;
+                }
+            }
+        } catch (...) {
+            while (top) {
+                Node* next = top->next.load(std::memory_order_relaxed);
+                destroy_node(top);
+                top = next;
+            }
+            throw;
         }
         
-        Node* old_head = head.load();
+        if (top) {
+            splice(top, bottom);
+        }
+    }
+    
+    // Забирает весь стек одним exchange и передает значения consumer(T&&)
+    // от вершины вниз. Возвращает число элементов
+    template<typename F>
+    size_t pop_all(F&& consumer) {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        size_t count = 0;
         
-        do {
-            Node* temp = old_head;
-            hp->pointer.store(old_head);
-            
-            // Перепроверяем, что head не изменился
-            old_head = head.load();
-            if (old_head != temp) {
-                continue;
-            }
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
             
-            if (!old_head) {
-                hp->pointer.store(nullptr);
-                return nullptr;
+            // Другие pop могли успеть защитить эти узлы - только через Reclaimer
+            try {
+                consumer(std::move(node->value));
+            } catch (...) {
+                Reclaimer::retire(node, &destroy_node);
+                if (next) {
+                    Node* bottom = next;
+                    while (Node* below = bottom->next.load(std::memory_order_relaxed)) {
+                        bottom = below;
+                    }
+                    splice(next, bottom);
+                }
+                throw;
             }
+            Reclaimer::retire(node, &destroy_node);
             
-        } while (!head.compare_exchange_weak(old_head, old_head->next.load()));
-        
-        hp->pointer.store(nullptr);
-        
-        std::unique_ptr<T> result;
-        if (old_head->data.load()) {
-            result = std::make_unique<T>(*old_head->data.load());
+            node = next;
+            ++count;
+        }
+        return count;
+    }
+    
+    // Значение перемещается из узла; выделений памяти нет
+    bool try_pop(T& out) {
+        typename Reclaimer::Guard guard;
+        bool eliminated;
+        Node* old_head = pop_node(guard, eliminated);
+        if (!old_head) {
+            return false;
         }
         
-        // Отложенное удаление
-        old_head->next.store(to_be_deleted.load());
-        while (!to_be_deleted.compare_exchange_weak(old_head->next.load(), old_head));
+        // Значение принадлежит только нам: остальные потоки читают лишь next
+        out = std::move(old_head->value);
         
-        // Периодически пытаемся удалить безопасные узлы
-        if (std::this_thread::get_id() == std::hash<std::thread::id>{}(std::this_thread::get_id()) % 10 == 0) {
-            delete_nodes_no_hazards();
+        release_popped(guard, old_head, eliminated);
+        return true;
+    }
+    
+    // Прежний интерфейс: одно дополнительное выделение под результат
+    std::unique_ptr<T> pop() {
+        typename Reclaimer::Guard guard;
+        bool eliminated;
+        Node* old_head = pop_node(guard, eliminated);
+        if (!old_head) {
+            return nullptr;
         }
         
+        auto result = std::make_unique<T>(std::move(old_head->value));
+        
+        release_popped(guard, old_head, eliminated);
         return result;
     }
     
+    // Включить/выключить массив элиминации (например, для сравнения)
+    void set_elimination(bool enabled) {
+        elimination_enabled_.store(enabled, std::memory_order_relaxed);
+    }
+    
+    // Сколько пар push/pop завершилось через массив элиминации
+    uint64_t eliminations() const {
+        return eliminations_.load(std::memory_order_relaxed);
+    }
+    
     bool empty() const {
         return head.load() == nullptr;
     }
+    
+    // Обращения к куче за узлами для всех стеков с этими T и Pooled
+    static uint64_t heap_allocations() {
+        return Allocator::heap_allocations();
+    }
 };
 
-// Статические члены
-template<typename T>
-std::array<typename LockFreeStack<T>::HazardPointer, LockFreeStack<T>::MAX_THREADS> 
-    LockFreeStack<T>::hazard_pointers = {};
+// Список свободных индексов над арифметикой «индекс + счетчик» в одном
+// 64-битном слове: голова = (tag << 32) | index, каждый CAS увеличивает tag,
+// так что ABA требует 2^32 операций между чтением и CAS одного потока.
+// Узлы живут в арене, которая не освобождается до разрушения владельца
+// (type-stable), поэтому чтение next у чужого, уже снятого узла безопасно и
+// никакой схемы освобождения не нужно. Обычный 64-битный CAS: не требует
+// cmpxchg16b/libatomic и места в указателе под тег
+class TaggedIndexList {
+public:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    
+private:
+    std::atomic<uint64_t> head_{EMPTY};
+    
+    static uint32_t index_of(uint64_t word) {
+        return static_cast<uint32_t>(word);
+    }
+    
+    static uint64_t make_word(uint32_t index, uint64_t previous) {
+        return ((previous >> 32) + 1) << 32 | index;
+    }
+    
+public:
+    // next[i] - поле связи узла i в арене владельца
+    void push(uint32_t index, std::atomic<uint32_t>* next) {
+        uint64_t old_head = head_.load(std::memory_order_relaxed);
+        do {
+            next[index].store(index_of(old_head), std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(old_head, make_word(index, old_head),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+    
+    uint32_t pop(std::atomic<uint32_t>* next) {
+        uint64_t old_head = head_.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t index = index_of(old_head);
+            if (index == EMPTY) {
+                return EMPTY;
+            }
+            
+            // Может быть устаревшим, если узел уже сняли, - тогда CAS не пройдет
+            uint32_t successor = next[index].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(old_head, make_word(successor, old_head),
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                return index;
+            }
+        }
+    }
+    
+    bool empty() const {
+        return index_of(head_.load(std::memory_order_relaxed)) == EMPTY;
+    }
+};
 
+// Стек ограниченной емкости для маленьких trivially copyable значений:
+// арена узлов, список свободных узлов и сам стек - два TaggedIndexList.
+// Ни выделений памяти после конструирования, ни hazard-указателей
 template<typename T>
-std::atomic<typename LockFreeStack<T>::Node*> LockFreeStack<T>::to_be_deleted{nullptr};
+class TaggedStack {
+    static_assert(std::is_trivially_copyable_v<T>, "TaggedStack требует trivially copyable T");
+    
+private:
+    std::unique_ptr<std::atomic<uint32_t>[]> next_;
+    std::unique_ptr<T[]> values_;
+    const uint32_t capacity_;
+    
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    alignas(CACHE_LINE_SIZE) TaggedIndexList stack_;
+    alignas(CACHE_LINE_SIZE) TaggedIndexList free_;
+    
+public:
+    explicit TaggedStack(uint32_t capacity)
+        : next_(new std::atomic<uint32_t>[capacity]),
+          values_(new T[capacity]),
+          capacity_(capacity) {
+        if (capacity == 0 || capacity == TaggedIndexList::EMPTY) {
+            throw std::invalid_argument("TaggedStack: недопустимая емкость");
+        }
+        for (uint32_t i = capacity; i > 0; --i) {
+            free_.push(i - 1, next_.get());
+        }
+    }
+    
+    TaggedStack(const TaggedStack&) = delete;
+    TaggedStack& operator=(const TaggedStack&) = delete;
+    
+    // false - арена исчерпана
+    bool try_push(const T& item) {
+        uint32_t index = free_.pop(next_.get());
+        if (index == TaggedIndexList::EMPTY) {
+            return false;
+        }
+        values_[index] = item;
+        stack_.push(index, next_.get());
+        return true;
+    }
+    
+    bool try_pop(T& out) {
+        uint32_t index = stack_.pop(next_.get());
+        if (index == TaggedIndexList::EMPTY) {
+            return false;
+        }
+        out = values_[index];
+        free_.push(index, next_.get());
+        return true;
+    }
+    
+    bool empty() const {
+        return stack_.empty();
+    }
+    
+    uint32_t capacity() const {
+        return capacity_;
+    }
+};
+
+// Пары push/try_pop в каждом потоке: пул узлов против кучи
+namespace lock_free_stack_benchmark
+{
+    struct Result {
+        double ops_per_second;
+        double heap_allocations_per_op;
+    };
+    
+    template<typename Stack>
+    Result run(size_t num_threads, size_t pairs_per_thread) {
+        Stack stack;
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        uint64_t allocations_before = Stack::heap_allocations();
+        
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t value = 0;
+                for (size_t i = 0; i < pairs_per_thread; ++i) {
+                    stack.push(i);
+                    stack.try_pop(value);
+                }
+            });
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        double operations = 2.0 * num_threads * pairs_per_thread;
+        return {
+            operations / seconds,
+            (Stack::heap_allocations() - allocations_before) / operations
+        };
+    }
+    
+    // Сильная конкуренция: все потоки делают push/try_pop на одном стеке.
+    // Возвращает операции в секунду; eliminated - доля пар, прошедших через
+    // массив элиминации
+    inline double run_contention(size_t num_threads, size_t pairs_per_thread,
+                                 bool elimination, double& eliminated) {
+        LockFreeStack<uint64_t> stack;
+        stack.set_elimination(elimination);
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t value = 0;
+                for (size_t i = 0; i < pairs_per_thread; ++i) {
+                    stack.push(i);
+                    stack.try_pop(value);
+                }
+            });
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        eliminated = static_cast<double>(stack.eliminations()) / (num_threads * pairs_per_thread);
+        return 2.0 * num_threads * pairs_per_thread / seconds;
+    }
+    
+    inline void run_contention_all(size_t pairs_per_thread = 100000) {
+        std::cout << "threads  plain Mops/s  elimination Mops/s  eliminated %\n";
+        for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+            double unused;
+            double eliminated;
+            double plain_ops = run_contention(threads, pairs_per_thread, false, unused);
+            double elimination_ops = run_contention(threads, pairs_per_thread, true, eliminated);
+            std::cout << std::setw(7) << threads
+                      << std::setw(14) << std::fixed << std::setprecision(2) << plain_ops / 1e6
+                      << std::setw(20) << elimination_ops / 1e6
+                      << std::setw(14) << eliminated * 100 << "\n";
+        }
+    }
+    
+    inline void run_all(size_t pairs_per_thread = 200000) {
+        using Pooled = LockFreeStack<uint64_t, reclamation::HazardPointers, true>;
+        using Heap = LockFreeStack<uint64_t, reclamation::HazardPointers, false>;
+        
+        std::cout << "threads  pool Mops/s  pool allocs/op  heap Mops/s  heap allocs/op\n";
+        for (size_t threads : {1, 2, 4, 8, 16}) {
+            Result pooled = run<Pooled>(threads, pairs_per_thread);
+            Result heap = run<Heap>(threads, pairs_per_thread);
+            std::cout << std::setw(7) << threads
+                      << std::setw(13) << std::fixed << std::setprecision(2) << pooled.ops_per_second / 1e6
+                      << std::setw(16) << std::setprecision(4) << pooled.heap_allocations_per_op
+                      << std::setw(13) << std::setprecision(2) << heap.ops_per_second / 1e6
+                      << std::setw(16) << std::setprecision(4) << heap.heap_allocations_per_op << "\n";
+        }
+    }
+    
+    // TaggedStack против LockFreeStack на hazard-указателях: пары
+    // push/try_pop, емкость арены с запасом на все потоки
+    template<typename Stack, typename Push>
+    double run_pairs(Stack& stack, size_t num_threads, size_t pairs_per_thread, Push push) {
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t value = 0;
+                for (size_t i = 0; i < pairs_per_thread; ++i) {
+                    push(stack, i);
+                    stack.try_pop(value);
+                }
+            });
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return 2.0 * num_threads * pairs_per_thread / seconds;
+    }
+    
+    inline void run_tagged_all(size_t pairs_per_thread = 200000) {
+        std::cout << "threads  hazard-pointer Mops/s  tagged Mops/s\n";
+        for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+            LockFreeStack<uint64_t> hazard_stack;
+            double hazard_ops = run_pairs(hazard_stack, threads, pairs_per_thread,
+                [](auto& stack, uint64_t value) { stack.push(value); });
+            
+            TaggedStack<uint64_t> tagged_stack(static_cast<uint32_t>(threads * 2));
+            double tagged_ops = run_pairs(tagged_stack, threads, pairs_per_thread,
+                [](auto& stack, uint64_t value) { stack.try_push(value); });
+            
+            std::cout << std::setw(7) << threads
+                      << std::setw(23) << std::fixed << std::setprecision(2) << hazard_ops / 1e6
+                      << std::setw(15) << tagged_ops / 1e6 << "\n";
+        }
+    }
+}
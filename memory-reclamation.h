@@ -0,0 +1,754 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Безопасное освобождение памяти для lock-free контейнеров.
+//
+// Обе схемы дают контейнеру одинаковый интерфейс:
+//   typename Reclaimer::Guard guard;       // защита на время операции
+//   Node* node = guard.protect(head);      // чтение указателя под защитой
+//   Reclaimer::retire(node);               // отложенное удаление после исключения из структуры
+// поэтому контейнер может принимать схему параметром шаблона.
+//
+// HazardPointers - каждый Guard публикует один указатель; память ограничена
+// (не больше O(потоков^2) неосвобожденных узлов), но каждый protect() - это
+// seq_cst запись и повторное чтение.
+// EpochReclamation - Guard отмечает поток в текущей эпохе, protect() - обычное
+// чтение; зато поток, застрявший внутри Guard, задерживает освобождение всего.
+namespace reclamation
+{
+    // Отложенное удаление: указатель и функция, которая его освободит
+    struct Retired {
+        void* pointer;
+        void (*deleter)(void*);
+
+        void reclaim() const {
+            deleter(pointer);
+        }
+    };
+
+    template<typename Node>
+    void delete_node(void* pointer) {
+        delete static_cast<Node*>(pointer);
+    }
+
+    // Узлы, оставшиеся после завершения потоков. Их забирает следующий
+    // поток, выполняющий освобождение
+    struct OrphanBatch {
+        std::vector<Retired> retired;
+        uint64_t epoch = 0;
+        OrphanBatch* next = nullptr;
+    };
+
+    class OrphanList {
+    private:
+        std::atomic<OrphanBatch*> head_{nullptr};
+
+    public:
+        OrphanList() = default;
+        OrphanList(const OrphanList&) = delete;
+        OrphanList& operator=(const OrphanList&) = delete;
+
+        ~OrphanList() {
+            OrphanBatch* batch = head_.load(std::memory_order_acquire);
+            while (batch) {
+                OrphanBatch* next = batch->next;
+                for (const Retired& retired : batch->retired) {
+                    retired.reclaim();
+                }
+                delete batch;
+                batch = next;
+            }
+        }
+
+        void push(OrphanBatch* batch) {
+            batch->next = head_.load(std::memory_order_relaxed);
+            while (!head_.compare_exchange_weak(batch->next, batch,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+            }
+        }
+
+        OrphanBatch* take_all() {
+            if (!head_.load(std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return head_.exchange(nullptr, std::memory_order_acquire);
+        }
+    };
+
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // Порог сканирования пропорционален числу потоков: при R >= 2*H (H - число
+    // hazard-слотов) каждое сканирование освобождает не меньше половины списка,
+    // так что амортизированная стоимость retire() - O(1)
+    constexpr size_t MIN_SCAN_THRESHOLD = 64;
+
+    class HazardPointers {
+    public:
+        static constexpr size_t SLOTS_PER_THREAD = 4;
+
+    private:
+        // Записи потоков никогда не удаляются, а переиспользуются после
+        // завершения потока, поэтому список только растет до пика потоков
+        struct alignas(CACHE_LINE_SIZE) Record {
+            std::array<std::atomic<void*>, SLOTS_PER_THREAD> slots{};
+            std::atomic<bool> active{false};
+            Record* next = nullptr;
+        };
+
+        struct Domain {
+            std::atomic<Record*> records{nullptr};
+            std::atomic<size_t> active_threads{0};
+            std::atomic<uint64_t> reclaimed{0};
+            OrphanList orphans;
+
+            ~Domain() {
+                Record* record = records.load(std::memory_order_acquire);
+                while (record) {
+                    Record* next = record->next;
+                    delete record;
+                    record = next;
+                }
+            }
+        };
+
+        static Domain& domain() {
+            static Domain instance;
+            return instance;
+        }
+
+        struct ThreadState {
+            Record* record;
+            size_t used_slots = 0;
+            std::vector<Retired> retired;
+
+            ThreadState() : record(acquire_record()) {}
+
+            ~ThreadState() {
+                scan(*this);
+                if (!retired.empty()) {
+                    domain().orphans.push(new OrphanBatch{std::move(retired)});
+                }
+                release_record(record);
+            }
+        };
+
+        static ThreadState& local() {
+            thread_local ThreadState state;
+            return state;
+        }
+
+        static Record* acquire_record() {
+            Domain& d = domain();
+            d.active_threads.fetch_add(1, std::memory_order_relaxed);
+
+            for (Record* record = d.records.load(std::memory_order_acquire); record; record = record->next) {
+                bool expected = false;
+                if (!record->active.load(std::memory_order_relaxed) &&
+                    record->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return record;
+                }
+            }
+
+            Record* record = new Record;
+            record->active.store(true, std::memory_order_relaxed);
+            record->next = d.records.load(std::memory_order_relaxed);
+            while (!d.records.compare_exchange_weak(record->next, record,
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+            }
+            return record;
+        }
+
+        static void release_record(Record* record) {
+            for (auto& slot : record->slots) {
+                slot.store(nullptr, std::memory_order_relaxed);
+            }
+            record->active.store(false, std::memory_order_release);
+            domain().active_threads.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        static size_t scan_threshold() {
+            size_t threads = domain().active_threads.load(std::memory_order_relaxed);
+            return std::max(MIN_SCAN_THRESHOLD, 2 * SLOTS_PER_THREAD * threads);
+        }
+
+        static void scan(ThreadState& state) {
+            Domain& d = domain();
+
+            if (OrphanBatch* batch = d.orphans.take_all()) {
+                while (batch) {
+                    OrphanBatch* next = batch->next;
+                    state.retired.insert(state.retired.end(), batch->retired.begin(), batch->retired.end());
+                    delete batch;
+                    batch = next;
+                }
+            }
+
+            // В паре с seq_cst записью в protect(): либо защищающий поток
+            // увидит, что узел уже исключен, либо мы увидим его hazard-указатель
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            std::vector<void*> hazards;
+            for (Record* record = d.records.load(std::memory_order_acquire); record; record = record->next) {
+                for (const auto& slot : record->slots) {
+                    if (void* pointer = slot.load(std::memory_order_acquire)) {
+                        hazards.push_back(pointer);
+                    }
+                }
+            }
+            std::sort(hazards.begin(), hazards.end());
+
+            // Освобождаем после разбора списка: deleter может сам вызвать retire()
+            std::vector<Retired> reclaimable;
+            auto still_hazardous = std::partition(state.retired.begin(), state.retired.end(),
+                [&hazards](const Retired& retired) {
+                    return std::binary_search(hazards.begin(), hazards.end(), retired.pointer);
+                });
+            reclaimable.assign(still_hazardous, state.retired.end());
+            state.retired.erase(still_hazardous, state.retired.end());
+
+            for (const Retired& retired : reclaimable) {
+                retired.reclaim();
+            }
+            d.reclaimed.fetch_add(reclaimable.size(), std::memory_order_relaxed);
+        }
+
+    public:
+        // Один hazard-слот потока. Guard'ы одного потока должны уничтожаться
+        // в обратном порядке создания (обычная вложенность областей видимости)
+        class Guard {
+        private:
+            std::atomic<void*>* slot_;
+
+        public:
+            Guard() {
+                ThreadState& state = local();
+                if (state.used_slots == SLOTS_PER_THREAD) {
+                    throw std::runtime_error("HazardPointers: закончились слоты потока");
+                }
+                slot_ = &state.record->slots[state.used_slots++];
+            }
+
+            ~Guard() {
+                slot_->store(nullptr, std::memory_order_release);
+                --local().used_slots;
+            }
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            // Публикуем указатель и перечитываем источник: если он не
+            // изменился, узел не мог быть освобожден до публикации
+            template<typename Node>
+            Node* protect(const std::atomic<Node*>& source) {
+                Node* pointer = source.load(std::memory_order_relaxed);
+                while (true) {
+                    slot_->store(pointer, std::memory_order_seq_cst);
+                    Node* current = source.load(std::memory_order_seq_cst);
+                    if (current == pointer) {
+                        return pointer;
+                    }
+                    pointer = current;
+                }
+            }
+
+            void reset() {
+                slot_->store(nullptr, std::memory_order_release);
+            }
+        };
+
+        // Узел уже исключен из структуры; будет освобожден, когда его не
+        // защищает ни один Guard
+        static void retire(void* pointer, void (*deleter)(void*)) {
+            ThreadState& state = local();
+            state.retired.push_back({pointer, deleter});
+            if (state.retired.size() >= scan_threshold()) {
+                scan(state);
+            }
+        }
+
+        template<typename Node>
+        static void retire(Node* node) {
+            retire(node, &delete_node<Node>);
+        }
+
+        // Освободить все, что возможно, не дожидаясь порога
+        static void flush() {
+            scan(local());
+        }
+
+        struct Statistics {
+            size_t active_threads;
+            uint64_t reclaimed;
+            size_t pending_in_thread;
+        };
+
+        static Statistics get_statistics() {
+            Domain& d = domain();
+            return {
+                d.active_threads.load(std::memory_order_relaxed),
+                d.reclaimed.load(std::memory_order_relaxed),
+                local().retired.size()
+            };
+        }
+    };
+
+    class EpochReclamation {
+    private:
+        // state записи: (эпоха << 1) | ACTIVE, пока поток внутри Guard
+        static constexpr uint64_t ACTIVE = 1;
+        static constexpr size_t BAGS = 3;
+
+        struct alignas(CACHE_LINE_SIZE) Record {
+            std::atomic<uint64_t> state{0};
+            std::atomic<bool> active{false};
+            Record* next = nullptr;
+        };
+
+        struct Domain {
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> epoch{BAGS};
+            alignas(CACHE_LINE_SIZE) std::atomic<Record*> records{nullptr};
+            std::atomic<size_t> active_threads{0};
+            std::atomic<uint64_t> reclaimed{0};
+            OrphanList orphans;
+
+            ~Domain() {
+                Record* record = records.load(std::memory_order_acquire);
+                while (record) {
+                    Record* next = record->next;
+                    delete record;
+                    record = next;
+                }
+            }
+        };
+
+        static Domain& domain() {
+            static Domain instance;
+            return instance;
+        }
+
+        // Узлы, удаленные в эпоху e, лежат в limbo[e % 3] и освобождаются,
+        // когда глобальная эпоха достигнет e + 2: к этому моменту все потоки
+        // дважды прошли через границу эпохи и ссылок на узлы не держат
+        struct ThreadState {
+            Record* record;
+            uint32_t nesting = 0;
+            size_t retired_since_advance = 0;
+            std::array<std::vector<Retired>, BAGS> limbo;
+            std::array<uint64_t, BAGS> limbo_epoch{};
+
+            ThreadState() : record(acquire_record()) {}
+
+            ~ThreadState() {
+                reclaim_safe(*this, try_advance());
+                for (size_t i = 0; i < BAGS; ++i) {
+                    if (!limbo[i].empty()) {
+                        domain().orphans.push(new OrphanBatch{std::move(limbo[i]), limbo_epoch[i]});
+                    }
+                }
+                record->state.store(0, std::memory_order_relaxed);
+                record->active.store(false, std::memory_order_release);
+                domain().active_threads.fetch_sub(1, std::memory_order_relaxed);
+            }
+        };
+
+        static ThreadState& local() {
+            thread_local ThreadState state;
+            return state;
+        }
+
+        static Record* acquire_record() {
+            Domain& d = domain();
+            d.active_threads.fetch_add(1, std::memory_order_relaxed);
+
+            for (Record* record = d.records.load(std::memory_order_acquire); record; record = record->next) {
+                bool expected = false;
+                if (!record->active.load(std::memory_order_relaxed) &&
+                    record->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return record;
+                }
+            }
+
+            Record* record = new Record;
+            record->active.store(true, std::memory_order_relaxed);
+            record->next = d.records.load(std::memory_order_relaxed);
+            while (!d.records.compare_exchange_weak(record->next, record,
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+            }
+            return record;
+        }
+
+        // Продвигаем эпоху, если все потоки внутри Guard уже в текущей
+        static uint64_t try_advance() {
+            Domain& d = domain();
+            uint64_t epoch = d.epoch.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            for (Record* record = d.records.load(std::memory_order_acquire); record; record = record->next) {
+                uint64_t state = record->state.load(std::memory_order_acquire);
+                if ((state & ACTIVE) && (state >> 1) != epoch) {
+                    return epoch;
+                }
+            }
+
+            if (d.epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst,
+                                                std::memory_order_relaxed)) {
+                return epoch + 1;
+            }
+            return epoch;
+        }
+
+        static void reclaim_bag(std::vector<Retired>& bag) {
+            std::vector<Retired> reclaimable;
+            reclaimable.swap(bag);
+            for (const Retired& retired : reclaimable) {
+                retired.reclaim();
+            }
+            domain().reclaimed.fetch_add(reclaimable.size(), std::memory_order_relaxed);
+        }
+
+        static void reclaim_safe(ThreadState& state, uint64_t global_epoch) {
+            for (size_t i = 0; i < BAGS; ++i) {
+                if (!state.limbo[i].empty() && state.limbo_epoch[i] + 2 <= global_epoch) {
+                    reclaim_bag(state.limbo[i]);
+                }
+            }
+
+            // Сироты, чья эпоха еще не истекла, возвращаются в список
+            if (OrphanBatch* batch = domain().orphans.take_all()) {
+                while (batch) {
+                    OrphanBatch* next = batch->next;
+                    if (batch->epoch + 2 <= global_epoch) {
+                        reclaim_bag(batch->retired);
+                        delete batch;
+                    } else {
+                        domain().orphans.push(batch);
+                    }
+                    batch = next;
+                }
+            }
+        }
+
+        static size_t advance_threshold() {
+            size_t threads = domain().active_threads.load(std::memory_order_relaxed);
+            return std::max(MIN_SCAN_THRESHOLD, 2 * threads);
+        }
+
+    public:
+        // Отмечает поток в текущей эпохе; вложенные Guard'ы бесплатны
+        class Guard {
+        private:
+            ThreadState& state_;
+
+        public:
+            Guard() : state_(local()) {
+                if (state_.nesting++ == 0) {
+                    uint64_t epoch = domain().epoch.load(std::memory_order_relaxed);
+                    state_.record->state.store((epoch << 1) | ACTIVE, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                }
+            }
+
+            ~Guard() {
+                if (--state_.nesting == 0) {
+                    state_.record->state.store(0, std::memory_order_release);
+                }
+            }
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            template<typename Node>
+            Node* protect(const std::atomic<Node*>& source) {
+                return source.load(std::memory_order_acquire);
+            }
+
+            void reset() {}
+        };
+
+        static void retire(void* pointer, void (*deleter)(void*)) {
+            ThreadState& state = local();
+            uint64_t epoch = domain().epoch.load(std::memory_order_seq_cst);
+
+            size_t bag = epoch % BAGS;
+            if (state.limbo_epoch[bag] != epoch) {
+                // В корзине эпоха не новее epoch - 3, ее можно освободить
+                if (!state.limbo[bag].empty()) {
+                    reclaim_bag(state.limbo[bag]);
+                }
+                state.limbo_epoch[bag] = epoch;
+            }
+            state.limbo[bag].push_back({pointer, deleter});
+
+            if (++state.retired_since_advance >= advance_threshold()) {
+                state.retired_since_advance = 0;
+                reclaim_safe(state, try_advance());
+            }
+        }
+
+        template<typename Node>
+        static void retire(Node* node) {
+            retire(node, &delete_node<Node>);
+        }
+
+        // Освободить все, что возможно: продвигает эпоху, сколько получится
+        static void flush() {
+            ThreadState& state = local();
+            for (size_t i = 0; i < BAGS; ++i) {
+                reclaim_safe(state, try_advance());
+            }
+        }
+
+        struct Statistics {
+            size_t active_threads;
+            uint64_t reclaimed;
+            size_t pending_in_thread;
+            uint64_t epoch;
+        };
+
+        static Statistics get_statistics() {
+            Domain& d = domain();
+            ThreadState& state = local();
+            size_t pending = 0;
+            for (const auto& bag : state.limbo) {
+                pending += bag.size();
+            }
+            return {
+                d.active_threads.load(std::memory_order_relaxed),
+                d.reclaimed.load(std::memory_order_relaxed),
+                pending,
+                d.epoch.load(std::memory_order_relaxed)
+            };
+        }
+    };
+
+    // Пул памяти под узлы одного типа: потоковый кеш без синхронизации и
+    // общий склад (depot), через который излишки переходят между потоками.
+    // Склад поддерживает только вставку цепочки и изъятие всего сразу
+    // (exchange), поэтому ABA в нем невозможна. Склад никогда не
+    // разрушается: узлы в него возвращаются и из деструкторов статических
+    // Domain'ов, которые могут пережить любой локальный static
+    template<typename Node>
+    class NodePool {
+    private:
+        struct FreeNode {
+            FreeNode* next;
+        };
+
+        static constexpr size_t SIZE = std::max(sizeof(Node), sizeof(FreeNode));
+        static constexpr size_t ALIGNMENT = std::max(alignof(Node), alignof(FreeNode));
+        static constexpr size_t LOCAL_LIMIT = 256;
+
+        struct Depot {
+            std::atomic<FreeNode*> head{nullptr};
+            std::atomic<uint64_t> heap_allocations{0};
+        };
+
+        // Намеренная утечка: ~Domain -> OrphanList -> destroy_node ->
+        // give_to_depot при выходе не должен попасть в разрушенный склад
+        static Depot& depot() {
+            static Depot& instance = *new Depot;
+            return instance;
+        }
+
+        // Тривиально разрушаемый: остается доступным, пока завершающийся
+        // поток освобождает узлы из деструкторов других thread_local
+        struct LocalCache {
+            FreeNode* head;
+            size_t count;
+            bool registered;
+            bool flushed;
+        };
+
+        static LocalCache& local() {
+            thread_local LocalCache cache{};
+            return cache;
+        }
+
+        // Отдает кеш на склад при завершении потока
+        struct CacheFlusher {
+            ~CacheFlusher() {
+                LocalCache& cache = local();
+                cache.flushed = true;
+                if (cache.head) {
+                    FreeNode* last = cache.head;
+                    while (last->next) {
+                        last = last->next;
+                    }
+                    give_to_depot(cache.head, last);
+                    cache.head = nullptr;
+                    cache.count = 0;
+                }
+            }
+        };
+
+        static void register_flusher(LocalCache& cache) {
+            if (!cache.registered) {
+                thread_local CacheFlusher flusher;
+                (void)flusher;
+                cache.registered = true;
+            }
+        }
+
+        static void give_to_depot(FreeNode* first, FreeNode* last) {
+            Depot& d = depot();
+            last->next = d.head.load(std::memory_order_relaxed);
+            while (!d.head.compare_exchange_weak(last->next, first,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+            }
+        }
+
+    public:
+        // Память под один Node; конструирует вызывающий
+        static void* allocate() {
+            LocalCache& cache = local();
+
+            if (!cache.head && !cache.flushed) {
+                register_flusher(cache);
+                cache.head = depot().head.exchange(nullptr, std::memory_order_acquire);
+                cache.count = 0;
+                for (FreeNode* node = cache.head; node; node = node->next) {
+                    ++cache.count;
+                }
+            }
+
+            if (!cache.head) {
+                depot().heap_allocations.fetch_add(1, std::memory_order_relaxed);
+                return ::operator new(SIZE, std::align_val_t(ALIGNMENT));
+            }
+
+            FreeNode* node = cache.head;
+            cache.head = node->next;
+            --cache.count;
+            return node;
+        }
+
+        // Память уже разрушенного Node
+        static void deallocate(void* memory) {
+            LocalCache& cache = local();
+            FreeNode* node = new (memory) FreeNode{nullptr};
+
+            if (cache.flushed) {
+                give_to_depot(node, node);
+                return;
+            }
+            register_flusher(cache);
+
+            node->next = cache.head;
+            cache.head = node;
+
+            // Излишки (обычно у потока-потребителя) уходят на склад половиной кеша
+            if (++cache.count > LOCAL_LIMIT) {
+                FreeNode* first = cache.head;
+                FreeNode* last = first;
+                for (size_t i = 1; i < LOCAL_LIMIT / 2; ++i) {
+                    last = last->next;
+                }
+                cache.head = last->next;
+                cache.count -= LOCAL_LIMIT / 2;
+                give_to_depot(first, last);
+            }
+        }
+
+        // Сколько раз пул обращался к куче (для бенчмарков)
+        static uint64_t heap_allocations() {
+            return depot().heap_allocations.load(std::memory_order_relaxed);
+        }
+    };
+
+    // Тот же интерфейс без пула: каждый узел - отдельное обращение к куче
+    template<typename Node>
+    class HeapNodes {
+    private:
+        static std::atomic<uint64_t>& allocations() {
+            static std::atomic<uint64_t> counter{0};
+            return counter;
+        }
+
+    public:
+        static void* allocate() {
+            allocations().fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(sizeof(Node), std::align_val_t(alignof(Node)));
+        }
+
+        static void deallocate(void* memory) {
+            ::operator delete(memory, std::align_val_t(alignof(Node)));
+        }
+
+        static uint64_t heap_allocations() {
+            return allocations().load(std::memory_order_relaxed);
+        }
+    };
+}
+
+// Сравнение схем: потоки читают общий указатель под Guard и каждую
+// write_every-ю операцию подменяют объект и отдают старый на освобождение
+namespace reclamation_benchmark
+{
+    struct Payload {
+        uint64_t values[4];
+    };
+
+    template<typename Reclaimer>
+    double run(size_t num_threads, size_t operations_per_thread, size_t write_every = 16) {
+        std::atomic<Payload*> shared{new Payload{}};
+        std::atomic<uint64_t> checksum{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                uint64_t local = 0;
+                for (size_t i = 0; i < operations_per_thread; ++i) {
+                    typename Reclaimer::Guard guard;
+                    if ((i + t) % write_every == 0) {
+                        Payload* fresh = new Payload{{i, i, i, i}};
+                        Reclaimer::retire(shared.exchange(fresh, std::memory_order_acq_rel));
+                    } else {
+                        local += guard.protect(shared)->values[i % 4];
+                    }
+                }
+                Reclaimer::flush();
+                checksum.fetch_add(local, std::memory_order_relaxed);
+            });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        delete shared.load();
+        return num_threads * operations_per_thread / seconds;
+    }
+
+    inline void run_all(size_t operations_per_thread = 200000) {
+        std::cout << "threads  HazardPointers Mops/s  EpochReclamation Mops/s\n";
+        for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+            double hazard_ops = run<reclamation::HazardPointers>(threads, operations_per_thread);
+            double epoch_ops = run<reclamation::EpochReclamation>(threads, operations_per_thread);
+            std::cout << std::setw(7) << threads
+                      << std::setw(23) << std::fixed << std::setprecision(2) << hazard_ops / 1e6
+                      << std::setw(25) << epoch_ops / 1e6 << "\n";
+        }
+    }
+}
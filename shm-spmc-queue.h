@@ -0,0 +1,628 @@
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Межпроцессный вариант SPMCQueue: кольцо со слотами-последовательностями
+// живет в разделяемой памяти (shm_open или memfd). Один процесс-producer,
+// несколько процессов-consumer'ов. Элементы копируются побайтно, поэтому
+// T обязан быть trivially copyable (указатели внутри - только смещения).
+// Упавшим считается и неубранный зомби, так что producer восстанавливает
+// слоты, не дожидаясь waitpid(). Переиспользование pid за время между
+// падением и восстановлением не отслеживается.
+template<typename T, size_t Capacity, size_t MaxConsumers = 64>
+class ShmSPMCQueue {
+private:
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be power of 2");
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "need address-free 64-bit atomics");
+    static_assert(std::atomic<int32_t>::is_always_lock_free, "need address-free 32-bit atomics");
+
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr uint64_t MAGIC = 0x314D4853434D5053ull; // "SPMCSHM1"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint64_t NO_CLAIM = ~uint64_t(0);
+    static constexpr int32_t RECOVERING = -1;   // pid записи, которую сейчас освобождают
+
+    // Запись о consumer-процессе. claimed - позиция, которую consumer
+    // пытается забрать или читает прямо сейчас; по ней восстанавливаются
+    // слоты упавших процессов
+    struct alignas(CACHE_LINE_SIZE) ConsumerEntry {
+        std::atomic<int32_t> pid;
+        std::atomic<uint64_t> claimed;
+        std::atomic<uint64_t> dequeued;
+    };
+
+    // Версионированный заголовок сегмента. magic пишется последним
+    struct Header {
+        std::atomic<uint64_t> magic;
+        uint32_t version;
+        uint32_t max_consumers;
+        uint64_t capacity;
+        uint64_t element_size;
+        uint64_t element_align;
+        uint64_t segment_size;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> producer_pos;
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> consumer_cursor;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> total_enqueued;
+        std::atomic<uint64_t> recovered_slots;
+
+        ConsumerEntry consumers[MaxConsumers];
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<uint64_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static constexpr size_t SLOTS_OFFSET =
+        (sizeof(Header) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    static constexpr size_t SEGMENT_SIZE = SLOTS_OFFSET + sizeof(Slot) * Capacity;
+
+    Header* header_ = nullptr;
+    Slot* slots_ = nullptr;
+    std::string name_;            // пусто для memfd
+    pid_t creator_pid_ = 0;       // unlink делает только создатель
+    int consumer_index_ = -1;     // запись в таблице consumer'ов этого процесса
+
+    ShmSPMCQueue(void* memory, std::string name, pid_t creator)
+        : header_(static_cast<Header*>(memory)),
+          slots_(reinterpret_cast<Slot*>(static_cast<char*>(memory) + SLOTS_OFFSET)),
+          name_(std::move(name)),
+          creator_pid_(creator) {}
+
+    static void* map_fd(int fd) {
+        void* memory = ::mmap(nullptr, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (memory == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        return memory;
+    }
+
+    static void* create_segment(int fd) {
+        if (::ftruncate(fd, SEGMENT_SIZE) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "ftruncate");
+        }
+
+        void* memory = map_fd(fd);
+        ::close(fd);
+
+        auto* header = ::new (memory) Header{};
+        header->version = VERSION;
+        header->max_consumers = MaxConsumers;
+        header->capacity = Capacity;
+        header->element_size = sizeof(T);
+        header->element_align = alignof(T);
+        header->segment_size = SEGMENT_SIZE;
+        for (auto& consumer : header->consumers) {
+            consumer.claimed.store(NO_CLAIM, std::memory_order_relaxed);
+        }
+
+        auto* slots = reinterpret_cast<Slot*>(static_cast<char*>(memory) + SLOTS_OFFSET);
+        for (size_t i = 0; i < Capacity; ++i) {
+            ::new (&slots[i]) Slot{};
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        header->magic.store(MAGIC, std::memory_order_release);
+        return memory;
+    }
+
+    void validate_header() const {
+        if (header_->magic.load(std::memory_order_acquire) != MAGIC) {
+            throw std::runtime_error("shm queue: bad magic or segment not initialized");
+        }
+        if (header_->version != VERSION) {
+            throw std::runtime_error("shm queue: unsupported version " +
+                                     std::to_string(header_->version));
+        }
+        if (header_->capacity != Capacity || header_->element_size != sizeof(T) ||
+            header_->element_align != alignof(T) || header_->max_consumers != MaxConsumers ||
+            header_->segment_size != SEGMENT_SIZE) {
+            throw std::runtime_error("shm queue: layout mismatch");
+        }
+    }
+
+    // kill(pid, 0) считает живым и зомби: упавший consumer, которого
+    // родитель еще не убрал waitpid(), остается в таблице процессов. Его
+    // состояние ('Z'/'X') берем из /proc/<pid>/stat; без /proc - как kill()
+    static bool process_alive(int32_t pid) {
+        if (pid <= 0 || (::kill(pid, 0) != 0 && errno == ESRCH)) {
+            return false;
+        }
+
+        char path[32];
+        std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return true;
+        }
+        char stat[256];
+        ssize_t length = ::read(fd, stat, sizeof(stat) - 1);
+        ::close(fd);
+        if (length <= 0) {
+            return true;
+        }
+        stat[length] = '\0';
+
+        // Формат: "pid (comm) state ..."; comm может содержать ')' и пробелы
+        const char* comm_end = std::strrchr(stat, ')');
+        return !(comm_end && comm_end[1] == ' ' && (comm_end[2] == 'Z' || comm_end[2] == 'X'));
+    }
+
+    void release_slot(uint64_t pos) {
+        slots_[pos & MASK].sequence.store(pos + Capacity, std::memory_order_release);
+    }
+
+    // Забирает одну позицию. Claim публикуется до CAS, поэтому consumer,
+    // выигравший позицию, виден в таблице, пока не освободит слот
+    bool dequeue_one(T& item) {
+        ConsumerEntry& self = header_->consumers[consumer_index_];
+
+        while (true) {
+            uint64_t pos = header_->consumer_cursor.load(std::memory_order_relaxed);
+            Slot& slot = slots_[pos & MASK];
+            uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+
+            if (seq == pos + 1) {
+                self.claimed.store(pos, std::memory_order_seq_cst);
+                if (header_->consumer_cursor.compare_exchange_weak(pos, pos + 1,
+                                                                  std::memory_order_seq_cst)) {
+                    std::memcpy(&item, slot.storage, sizeof(T));
+                    release_slot(pos);
+                    self.claimed.store(NO_CLAIM, std::memory_order_release);
+                    self.dequeued.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                // Другой consumer опередил нас, повторяем
+            } else if (seq < pos + 1) {
+                self.claimed.store(NO_CLAIM, std::memory_order_relaxed);
+                return false; // Очередь пуста
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+public:
+    // Именованный сегмент POSIX shm. Создатель удаляет имя в деструкторе
+    static ShmSPMCQueue create(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+        }
+        return ShmSPMCQueue(create_segment(fd), name, ::getpid());
+    }
+
+    // Анонимный сегмент memfd: доступен процессам, созданным через fork()
+    static ShmSPMCQueue create_anonymous(const char* debug_name = "spmc-shm") {
+        int fd = ::memfd_create(debug_name, MFD_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "memfd_create");
+        }
+        return ShmSPMCQueue(create_segment(fd), {}, ::getpid());
+    }
+
+    static ShmSPMCQueue open(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != SEGMENT_SIZE) {
+            ::close(fd);
+            throw std::runtime_error("shm queue: segment size mismatch");
+        }
+
+        void* memory = map_fd(fd);
+        ::close(fd);
+
+        ShmSPMCQueue queue(memory, {}, 0);
+        queue.validate_header();
+        return queue;
+    }
+
+    ShmSPMCQueue(ShmSPMCQueue&& other) noexcept
+        : header_(std::exchange(other.header_, nullptr)),
+          slots_(std::exchange(other.slots_, nullptr)),
+          name_(std::move(other.name_)),
+          creator_pid_(std::exchange(other.creator_pid_, 0)),
+          consumer_index_(std::exchange(other.consumer_index_, -1)) {}
+
+    ShmSPMCQueue(const ShmSPMCQueue&) = delete;
+    ShmSPMCQueue& operator=(const ShmSPMCQueue&) = delete;
+    ShmSPMCQueue& operator=(ShmSPMCQueue&&) = delete;
+
+    ~ShmSPMCQueue() {
+        if (!header_) return;
+
+        detach_consumer();
+        ::munmap(header_, SEGMENT_SIZE);
+
+        if (!name_.empty() && creator_pid_ == ::getpid()) {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    // Регистрирует текущий процесс как consumer'а. Нужно вызвать до dequeue
+    void attach_consumer() {
+        if (consumer_index_ >= 0) return;
+
+        recover_dead_consumers();
+
+        int32_t pid = ::getpid();
+        for (size_t i = 0; i < MaxConsumers; ++i) {
+            int32_t expected = 0;
+            ConsumerEntry& entry = header_->consumers[i];
+            if (entry.pid.compare_exchange_strong(expected, pid)) {
+                entry.claimed.store(NO_CLAIM, std::memory_order_relaxed);
+                entry.dequeued.store(0, std::memory_order_relaxed);
+                consumer_index_ = static_cast<int>(i);
+                return;
+            }
+        }
+        throw std::runtime_error("shm queue: consumer table is full");
+    }
+
+    void detach_consumer() {
+        if (consumer_index_ < 0) return;
+
+        ConsumerEntry& entry = header_->consumers[consumer_index_];
+        entry.claimed.store(NO_CLAIM, std::memory_order_relaxed);
+        entry.pid.store(0, std::memory_order_release);
+        consumer_index_ = -1;
+    }
+
+    // Освобождает слоты, которые забрали и не успели вернуть упавшие процессы
+    // (элементы в них теряются), и записи этих процессов в таблице.
+    // Слот принадлежит мертвому, если курсор ушел дальше его позиции, слот
+    // не освобожден и ни один живой consumer его не заявил. Возвращает число
+    // восстановленных слотов.
+    size_t recover_dead_consumers() {
+        size_t recovered = 0;
+
+        for (auto& dead : header_->consumers) {
+            int32_t pid = dead.pid.load(std::memory_order_acquire);
+            if (pid <= 0 || process_alive(pid)) continue;
+
+            // Сначала забираем запись себе: иначе другой восстанавливающий
+            // процесс мог бы уже освободить ее, новый consumer - занять,
+            // а мы стерли бы его claimed
+            if (!dead.pid.compare_exchange_strong(pid, RECOVERING, std::memory_order_acq_rel)) {
+                continue;
+            }
+
+            uint64_t pos = dead.claimed.load(std::memory_order_seq_cst);
+            if (pos != NO_CLAIM &&
+                header_->consumer_cursor.load(std::memory_order_seq_cst) > pos) {
+
+                bool claimed_by_live = false;
+                for (auto& other : header_->consumers) {
+                    if (&other != &dead &&
+                        other.claimed.load(std::memory_order_seq_cst) == pos &&
+                        process_alive(other.pid.load(std::memory_order_relaxed))) {
+                        claimed_by_live = true;
+                        break;
+                    }
+                }
+
+                uint64_t full = pos + 1;
+                if (!claimed_by_live &&
+                    slots_[pos & MASK].sequence.compare_exchange_strong(
+                        full, pos + Capacity, std::memory_order_acq_rel)) {
+                    header_->recovered_slots.fetch_add(1, std::memory_order_relaxed);
+                    ++recovered;
+                }
+            }
+
+            dead.claimed.store(NO_CLAIM, std::memory_order_relaxed);
+            dead.pid.store(0, std::memory_order_release);
+        }
+
+        return recovered;
+    }
+
+    // Single Producer - неблокирующий enqueue
+    bool try_enqueue(const T& item) {
+        uint64_t pos = header_->producer_pos.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & MASK];
+
+        if (slot.sequence.load(std::memory_order_acquire) != pos) {
+            return false; // Очередь полна
+        }
+
+        std::memcpy(slot.storage, &item, sizeof(T));
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        header_->producer_pos.store(pos + 1, std::memory_order_relaxed);
+        header_->total_enqueued.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Single Producer - блокирующий enqueue. Если очередь долго полна,
+    // проверяет, не умер ли consumer, держащий слот
+    void enqueue(const T& item) {
+        uint32_t attempts = 0;
+        while (!try_enqueue(item)) {
+            if ((++attempts & 0x3FF) == 0) {
+                recover_dead_consumers();
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Single Producer - batch enqueue
+    template<typename Iterator>
+    size_t try_enqueue_batch(Iterator begin, Iterator end) {
+        uint64_t pos = header_->producer_pos.load(std::memory_order_relaxed);
+        size_t enqueued = 0;
+
+        for (auto it = begin; it != end; ++it, ++enqueued) {
+            Slot& slot = slots_[(pos + enqueued) & MASK];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + enqueued) {
+                break; // Очередь заполнена
+            }
+
+            const T& value = *it;
+            std::memcpy(slot.storage, &value, sizeof(T));
+            slot.sequence.store(pos + enqueued + 1, std::memory_order_release);
+        }
+
+        if (enqueued > 0) {
+            header_->producer_pos.store(pos + enqueued, std::memory_order_relaxed);
+            header_->total_enqueued.fetch_add(enqueued, std::memory_order_relaxed);
+        }
+        return enqueued;
+    }
+
+    // Multiple Consumer (процессы после attach_consumer) - неблокирующий dequeue
+    bool try_dequeue(T& item) {
+        if (consumer_index_ < 0) {
+            throw std::logic_error("shm queue: attach_consumer() first");
+        }
+        return dequeue_one(item);
+    }
+
+    // Multiple Consumer - batch dequeue
+    template<typename OutputIterator>
+    size_t try_dequeue_batch(OutputIterator out, size_t max_count) {
+        if (consumer_index_ < 0) {
+            throw std::logic_error("shm queue: attach_consumer() first");
+        }
+
+        size_t dequeued = 0;
+        T item;
+        while (dequeued < max_count && dequeue_one(item)) {
+            *out++ = item;
+            ++dequeued;
+        }
+        return dequeued;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t size() const {
+        uint64_t producer = header_->producer_pos.load(std::memory_order_relaxed);
+        uint64_t consumer = header_->consumer_cursor.load(std::memory_order_relaxed);
+        return producer > consumer ? producer - consumer : 0;
+    }
+
+    size_t capacity() const {
+        return Capacity;
+    }
+
+    struct Statistics {
+        uint64_t total_enqueued;
+        uint64_t total_dequeued;
+        uint64_t recovered_slots;
+        size_t live_consumers;
+        size_t current_size;
+    };
+
+    Statistics get_statistics() const {
+        uint64_t dequeued = 0;
+        size_t live = 0;
+        for (auto& consumer : header_->consumers) {
+            dequeued += consumer.dequeued.load(std::memory_order_relaxed);
+            if (process_alive(consumer.pid.load(std::memory_order_relaxed))) ++live;
+        }
+
+        return {
+            header_->total_enqueued.load(std::memory_order_relaxed),
+            dequeued,
+            header_->recovered_slots.load(std::memory_order_relaxed),
+            live,
+            size()
+        };
+    }
+};
+
+// Сравнение с Unix-domain socket: один producer-процесс, consumers - дочерние
+// процессы после fork()
+namespace shm_spmc_benchmark
+{
+    struct Message {
+        uint64_t sequence;
+        uint64_t payload[7];
+    };
+
+    inline double run_shm(size_t messages, int consumers) {
+        auto queue = ShmSPMCQueue<Message, 4096>::create_anonymous();
+
+        // Флаг "producer закончил" в общей анонимной памяти
+        void* flag_memory = ::mmap(nullptr, sizeof(std::atomic<bool>), PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (flag_memory == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        auto* done = ::new (flag_memory) std::atomic<bool>(false);
+
+        std::vector<pid_t> children;
+        for (int c = 0; c < consumers; ++c) {
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                queue.attach_consumer();
+                Message batch[64];
+                while (true) {
+                    bool finished = done->load(std::memory_order_acquire);
+                    if (queue.try_dequeue_batch(batch, 64) == 0) {
+                        if (finished) _exit(0);
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            children.push_back(pid);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Message message{};
+        for (size_t i = 0; i < messages; ++i) {
+            message.sequence = i;
+            queue.enqueue(message);
+        }
+        done->store(true, std::memory_order_release);
+        for (pid_t pid : children) {
+            ::waitpid(pid, nullptr, 0);
+        }
+        ::munmap(flag_memory, sizeof(std::atomic<bool>));
+
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Падение consumer'а: один из двух дочерних процессов убивается SIGKILL
+    // посреди потока и не убирается waitpid() до конца прогона. Producer
+    // должен дойти до конца, восстановив слот, если убитый держал его
+    inline void run_crash_recovery(size_t messages = 1000000) {
+        using Queue = ShmSPMCQueue<Message, 64>;
+        auto queue = Queue::create_anonymous();
+
+        void* shared_memory = ::mmap(nullptr, 2 * sizeof(std::atomic<uint64_t>), PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (shared_memory == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        auto* done = ::new (shared_memory) std::atomic<uint64_t>(0);
+        auto* received = ::new (done + 1) std::atomic<uint64_t>(0);
+
+        auto spawn = [&]() {
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                queue.attach_consumer();
+                Message message;
+                while (true) {
+                    bool finished = done->load(std::memory_order_acquire) != 0;
+                    if (queue.try_dequeue(message)) {
+                        received->fetch_add(1, std::memory_order_relaxed);
+                    } else if (finished) {
+                        _exit(0);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            return pid;
+        };
+        pid_t victim = spawn();
+        pid_t survivor = spawn();
+
+        Message message{};
+        for (size_t i = 0; i < messages; ++i) {
+            if (i == messages / 2) {
+                ::kill(victim, SIGKILL);
+            }
+            message.sequence = i;
+            queue.enqueue(message);
+        }
+        done->store(1, std::memory_order_release);
+        ::waitpid(survivor, nullptr, 0);
+
+        auto stats = queue.get_statistics();
+        // Убитый мог забрать элемент и не успеть его учесть: потерь не
+        // больше recovered_slots + 1
+        std::cout << "crash recovery: producer finished, received "
+                  << received->load() << " of " << messages
+                  << ", recovered slots " << stats.recovered_slots
+                  << ", live consumers " << stats.live_consumers << "\n";
+
+        ::waitpid(victim, nullptr, 0);
+        ::munmap(shared_memory, 2 * sizeof(std::atomic<uint64_t>));
+    }
+
+    inline double run_unix_socket(size_t messages, int consumers) {
+        // SOCK_SEQPACKET сохраняет границы сообщений; consumers читают один сокет
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) != 0) {
+            throw std::system_error(errno, std::generic_category(), "socketpair");
+        }
+        const uint64_t STOP = ~uint64_t(0);
+
+        std::vector<pid_t> children;
+        for (int c = 0; c < consumers; ++c) {
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                ::close(fds[0]);
+                Message message;
+                while (::recv(fds[1], &message, sizeof(message), 0) == sizeof(message)) {
+                    if (message.sequence == STOP) break;
+                }
+                _exit(0);
+            }
+            children.push_back(pid);
+        }
+        ::close(fds[1]);
+
+        auto start = std::chrono::steady_clock::now();
+        Message message{};
+        for (size_t i = 0; i < messages; ++i) {
+            message.sequence = i;
+            ::send(fds[0], &message, sizeof(message), 0);
+        }
+        message.sequence = STOP;
+        for (int c = 0; c < consumers; ++c) {
+            ::send(fds[0], &message, sizeof(message), 0);
+        }
+        for (pid_t pid : children) {
+            ::waitpid(pid, nullptr, 0);
+        }
+        ::close(fds[0]);
+
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    inline void run(size_t messages = 2000000) {
+        std::cout << "consumers  shm Mmsg/s  unix-socket Mmsg/s\n";
+        for (int consumers : {1, 2, 4}) {
+            double shm = run_shm(messages, consumers);
+            double uds = run_unix_socket(messages, consumers);
+            std::cout << std::setw(9) << consumers
+                      << std::setw(12) << std::fixed << std::setprecision(2) << messages / shm / 1e6
+                      << std::setw(20) << messages / uds / 1e6 << "\n";
+        }
+        run_crash_recovery();
+    }
+}
@@ -3,6 +3,14 @@
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <utility>
 
 template<typename T, size_t Capacity>
 class SPMCQueue {
@@ -11,9 +19,16 @@ private:
     static constexpr size_t MASK = Capacity - 1;
     static constexpr size_t CACHE_LINE_SIZE = 64;
     
+    // Слот хранит сырую память под T: объект создается placement new
+    // при записи и разрушается при чтении, поэтому T не обязан быть
+    // default-constructible, а сообщения можно строить прямо в буфере
     struct alignas(CACHE_LINE_SIZE) Slot {
         std::atomic<size_t> sequence{0};
-        T data;
+        alignas(T) unsigned char storage[sizeof(T)];
+        
+        T* ptr() noexcept {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
     };
     
     // Producer данные (выровнены по кеш-линии)
@@ -39,6 +54,21 @@ public:
         }
     }
     
+    ~SPMCQueue() {
+        // Разрушаем элементы, которые так и не были прочитаны
+        size_t producer = producer_pos_.load(std::memory_order_relaxed);
+        for (size_t pos = consumer_cursor_.load(std::memory_order_relaxed);
+             pos != producer; ++pos) {
+            Slot& slot = buffer_[pos & MASK];
+            if (slot.sequence.load(std::memory_order_acquire) == pos + 1) {
+                slot.ptr()->~T();
+            }
+        }
+    }
+    
+    SPMCQueue(const SPMCQueue&) = delete;
+    SPMCQueue& operator=(const SPMCQueue&) = delete;
+    
     // Single Producer - неблокирующий enqueue
     template<typename U>
     bool try_enqueue(U&& item) {
@@ -48,7 +78,7 @@ public:
         
         if (seq == pos) {
             // Слот готов для записи
-            slot.data = std::forward<U>(item);
+            ::new (static_cast<void*>(slot.storage)) T(std::forward<U>(item));
             slot.sequence.store(pos + 1, std::memory_order_release);
             producer_pos_.store(pos + 1, std::memory_order_relaxed);
             
@@ -84,7 +114,7 @@ public:
                 break; // Очередь заполнена
             }
             
-            slot.data = *it;
+            ::new (static_cast<void*>(slot.storage)) T(*it);
             slot.sequence.store(pos + enqueued + 1, std::memory_order_release);
         }
         
@@ -108,7 +138,8 @@ public:
                 // Данные готовы для чтения
                 if (consumer_cursor_.compare_exchange_weak(pos, pos + 1, 
                                                          std::memory_order_relaxed)) {
-                    item = std::move(slot.data);
+                    item = std::move(*slot.ptr());
+                    slot.ptr()->~T();
                     slot.sequence.store(pos + Capacity, std::memory_order_release);
                     
                     total_dequeued_.fetch_add(1, std::memory_order_relaxed);
@@ -141,7 +172,6 @@ public:
         if (max_count == 0) return 0;
         
         size_t dequeued = 0;
-        T item;
         
         // Пытаемся получить эксклюзивный доступ к блоку элементов
         while (dequeued < max_count) {
@@ -152,7 +182,8 @@ public:
             if (seq == pos + 1) {
                 if (consumer_cursor_.compare_exchange_weak(pos, pos + 1,
                                                          std::memory_order_relaxed)) {
-                    *out++ = std::move(slot.data);
+                    *out++ = std::move(*slot.ptr());
+                    slot.ptr()->~T();
                     slot.sequence.store(pos + Capacity, std::memory_order_release);
                     ++dequeued;
                 }
@@ -171,6 +202,157 @@ public:
         return dequeued;
     }
     
+    // Zero-copy API: запись и чтение прямо в слоте очереди, без
+    // перемещений и аллокаций. Удобно для крупных сообщений.
+    
+    // Single Producer - резервирует следующий слот. Возвращает указатель на
+    // неинициализированную память под T (объект строится через placement new)
+    // или nullptr, если очередь полна. После конструирования вызвать commit().
+    T* try_claim() {
+        size_t pos = producer_pos_.load(std::memory_order_relaxed);
+        Slot& slot = buffer_[pos & MASK];
+        
+        if (slot.sequence.load(std::memory_order_acquire) != pos) {
+            return nullptr; // Очередь полна
+        }
+        return reinterpret_cast<T*>(slot.storage);
+    }
+    
+    // Single Producer - публикует объект, построенный в слоте из try_claim()
+    void commit() {
+        size_t pos = producer_pos_.load(std::memory_order_relaxed);
+        buffer_[pos & MASK].sequence.store(pos + 1, std::memory_order_release);
+        producer_pos_.store(pos + 1, std::memory_order_relaxed);
+        
+        total_enqueued_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Single Producer - claim + конструирование на месте + commit
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        T* place = try_claim();
+        if (!place) {
+            return false;
+        }
+        ::new (static_cast<void*>(place)) T(std::forward<Args>(args)...);
+        commit();
+        return true;
+    }
+    
+    // Элемент, захваченный consumer'ом через try_peek(). Слот остается занятым
+    // (producer не может его переиспользовать), пока handle жив: деструктор
+    // освобождает слот, release() делает это раньше. Handle только
+    // перемещается и должен быть уничтожен до очереди
+    class PeekHandle {
+    private:
+        friend class SPMCQueue;
+        SPMCQueue* queue_ = nullptr;
+        T* item_ = nullptr;
+        size_t pos_ = 0;
+        
+    public:
+        PeekHandle() = default;
+        
+        PeekHandle(PeekHandle&& other) noexcept
+            : queue_(other.queue_), item_(std::exchange(other.item_, nullptr)), pos_(other.pos_) {}
+        
+        PeekHandle& operator=(PeekHandle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                queue_ = other.queue_;
+                item_ = std::exchange(other.item_, nullptr);
+                pos_ = other.pos_;
+            }
+            return *this;
+        }
+        
+        PeekHandle(const PeekHandle&) = delete;
+        PeekHandle& operator=(const PeekHandle&) = delete;
+        
+        ~PeekHandle() {
+            reset();
+        }
+        
+        // Освобождает слот досрочно; повторный вызов ничего не делает
+        void reset() {
+            if (item_) {
+                queue_->release(*this);
+            }
+        }
+        
+        explicit operator bool() const noexcept { return item_ != nullptr; }
+        T& operator*() const noexcept { return *item_; }
+        T* operator->() const noexcept { return item_; }
+        T* get() const noexcept { return item_; }
+    };
+    
+private:
+    // Захват очередного элемента без учета в статистике; пустой handle -
+    // очередь пуста
+    PeekHandle claim_next() {
+        PeekHandle handle;
+        
+        while (true) {
+            size_t pos = consumer_cursor_.load(std::memory_order_relaxed);
+            Slot& slot = buffer_[pos & MASK];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            
+            if (seq == pos + 1) {
+                if (consumer_cursor_.compare_exchange_weak(pos, pos + 1,
+                                                         std::memory_order_relaxed)) {
+                    handle.queue_ = this;
+                    handle.item_ = slot.ptr();
+                    handle.pos_ = pos;
+                    return handle;
+                }
+                // Другой consumer опередил нас, повторяем
+            } else if (seq < pos + 1) {
+                // Очередь пуста
+                return handle;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+    
+    void free_slot(PeekHandle& handle) {
+        handle.item_->~T();
+        buffer_[handle.pos_ & MASK].sequence.store(handle.pos_ + Capacity,
+                                                   std::memory_order_release);
+        handle.item_ = nullptr;
+    }
+    
+public:
+    // Multiple Consumer - захватывает очередной элемент для чтения на месте
+    PeekHandle try_peek() {
+        PeekHandle handle = claim_next();
+        if (!handle) {
+            failed_dequeues_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return handle;
+    }
+    
+    // Multiple Consumer - разрушает элемент и возвращает слот producer'у
+    void release(PeekHandle& handle) {
+        if (!handle) {
+            return;
+        }
+        
+        free_slot(handle);
+        total_dequeued_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Multiple Consumer - отбрасывает самый старый элемент (DropOldest).
+    // В статистику dequeue не попадает; false - очередь пуста
+    bool try_drop_oldest() {
+        PeekHandle handle = claim_next();
+        if (!handle) {
+            return false;
+        }
+        free_slot(handle);
+        return true;
+    }
+    
     // Утилитарные методы
     bool empty() const {
         size_t producer = producer_pos_.load(std::memory_order_relaxed);
@@ -228,6 +410,7 @@ public:
 };
 
 // Специализация для move-only типов
+// (аллоцирует каждый элемент; для работы без аллокаций см. SPMCQueue::try_claim/try_peek)
 template<typename T, size_t Capacity>
 class SPMCMoveOnlyQueue {
 private:
@@ -262,60 +445,304 @@ public:
     void reset_statistics() { queue_.reset_statistics(); }
 };
 
+// Поведение produce() при заполненной очереди
+enum class BackpressurePolicy {
+    Block,      // ждать освобождения слота (spin + yield)
+    DropOldest, // выбросить самый старый элемент очереди
+    DropNewest, // выбросить новый элемент
+    CallerRuns  // обработать элемент в потоке producer'а
+};
+
+// Параметры автомасштабирования пула consumer'ов
+struct SPMCScalingConfig {
+    size_t min_consumers = 1;
+    size_t max_consumers = std::max(1u, std::thread::hardware_concurrency());
+    
+    // Добавляем consumer, если заполненность очереди или оценка времени
+    // ожидания элемента (по закону Литтла: size / скорость выборки)
+    // превышает порог
+    double scale_up_occupancy = 0.5;
+    std::chrono::microseconds scale_up_wait{1000};
+    
+    // Consumer, простаивающий дольше idle_timeout, завершается
+    std::chrono::milliseconds idle_timeout{200};
+    std::chrono::milliseconds check_interval{10};
+};
+
+// Параметры адаптивного батчинга. Каждый consumer подстраивает размер пачки
+// и время ожидания ее дозаполнения (linger) под целевую задержку: при
+// высокой нагрузке пачки растут, при низкой linger падает до нуля
+struct SPMCBatchConfig {
+    size_t min_batch = 1;
+    size_t max_batch = 1024;
+    size_t initial_batch = 64;
+    std::chrono::microseconds target_latency{1000};
+    std::chrono::microseconds max_linger{100};
+};
+
 // Высокоуровневый интерфейс с автоматическим управлением потоками
 template<typename T, size_t Capacity = 1024>
 class ManagedSPMCSystem {
 private:
+    using Clock = std::chrono::steady_clock;
+    
+    struct Consumer {
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+    
     SPMCQueue<T, Capacity> queue_;
-    std::vector<std::thread> consumers_;
     std::atomic<bool> running_{true};
     
-    // Функциональные объекты для обработки
+    // Пул consumer'ов (изменяется супервизором и stop())
+    std::mutex consumers_mutex_;
+    std::vector<std::unique_ptr<Consumer>> consumers_;
+    std::atomic<size_t> active_consumers_{0};
+    bool use_batching_ = false;
+    
+    // Автомасштабирование
+    bool autoscaling_ = false;
+    SPMCScalingConfig scaling_;
+    std::thread supervisor_;
+    std::atomic<size_t> scale_ups_{0};
+    std::atomic<size_t> scale_downs_{0};
+    
+    // Backpressure
+    std::atomic<BackpressurePolicy> policy_{BackpressurePolicy::Block};
+    std::atomic<size_t> blocked_produces_{0};
+    std::atomic<uint64_t> blocked_time_ns_{0};
+    std::atomic<size_t> dropped_oldest_{0};
+    std::atomic<size_t> dropped_newest_{0};
+    std::atomic<size_t> caller_runs_{0};
+    
+    // Крайний срок дренирования очереди при остановке
+    std::atomic<Clock::rep> drain_deadline_{Clock::time_point::max().time_since_epoch().count()};
+    
+    // Адаптивный батчинг
+    SPMCBatchConfig batching_;
+    std::atomic<size_t> current_batch_limit_{0};
+    std::atomic<uint64_t> current_linger_ns_{0};
+    std::atomic<size_t> batches_processed_{0};
+    std::atomic<size_t> batched_items_{0};
+    
+    // Функциональные объекты для обработки. Batch-обработчик получает
+    // span поверх переиспользуемого буфера consumer'а
     std::function<void(T)> item_processor_;
-    std::function<void(std::vector<T>)> batch_processor_;
+    std::function<void(std::span<T>)> batch_processor_;
     
-    void consumer_loop(size_t consumer_id, bool use_batching) {
-        if (use_batching && batch_processor_) {
-            std::vector<T> batch;
-            batch.reserve(64);
-            
-            while (running_.load(std::memory_order_relaxed)) {
-                size_t dequeued = queue_.try_dequeue_batch(
-                    std::back_inserter(batch), 64);
-                
-                if (dequeued > 0) {
-                    batch_processor_(std::move(batch));
-                    batch.clear();
-                    batch.reserve(64);
-                } else {
-                    std::this_thread::sleep_for(std::chrono::microseconds(100));
-                }
-            }
-            
-            // Обрабатываем оставшиеся элементы
-            T item;
-            while (queue_.try_dequeue(item)) {
-                batch.push_back(std::move(item));
-            }
-            if (!batch.empty()) {
-                batch_processor_(std::move(batch));
+    template<typename BatchProcessor>
+    static std::function<void(std::span<T>)> make_batch_processor(BatchProcessor&& processor) {
+        if constexpr (std::is_invocable_v<BatchProcessor&, std::span<T>>) {
+            return std::forward<BatchProcessor>(processor);
+        } else {
+            // Совместимость со старыми обработчиками, принимающими std::vector<T>
+            return [p = std::forward<BatchProcessor>(processor)](std::span<T> batch) mutable {
+                p(std::vector<T>(std::make_move_iterator(batch.begin()),
+                                 std::make_move_iterator(batch.end())));
+            };
+        }
+    }
+    
+    bool before_drain_deadline() const {
+        return Clock::now().time_since_epoch().count() <
+               drain_deadline_.load(std::memory_order_relaxed);
+    }
+    
+    // Consumer решает завершиться сам, если он простаивает и пул больше минимума
+    bool try_retire(Clock::time_point idle_since) {
+        if (!autoscaling_ || !running_.load(std::memory_order_relaxed) ||
+            Clock::now() - idle_since < scaling_.idle_timeout) {
+            return false;
+        }
+        
+        size_t active = active_consumers_.load(std::memory_order_relaxed);
+        while (active > scaling_.min_consumers) {
+            if (active_consumers_.compare_exchange_weak(active, active - 1,
+                                                        std::memory_order_relaxed)) {
+                scale_downs_.fetch_add(1, std::memory_order_relaxed);
+                return true;
             }
+        }
+        return false;
+    }
+    
+    void consumer_loop(Consumer& self) {
+        auto idle_since = Clock::now();
+        bool retired = false;
+        
+        if (use_batching_ && batch_processor_) {
+            retired = batch_consumer_loop(idle_since);
             
         } else if (item_processor_) {
             T item;
             while (running_.load(std::memory_order_relaxed)) {
                 if (queue_.try_dequeue(item)) {
                     item_processor_(std::move(item));
+                    idle_since = Clock::now();
+                } else if (try_retire(idle_since)) {
+                    retired = true;
+                    break;
                 } else {
                     std::this_thread::sleep_for(std::chrono::microseconds(100));
                 }
             }
             
-            // Обрабатываем оставшиеся элементы
-            while (queue_.try_dequeue(item)) {
+            // Обрабатываем оставшиеся элементы до крайнего срока
+            while (!retired && before_drain_deadline() && queue_.try_dequeue(item)) {
                 item_processor_(std::move(item));
             }
         }
+        
+        if (!retired) {
+            active_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        self.finished.store(true, std::memory_order_release);
+    }
+    
+    // Цикл batch-consumer'а. Возвращает true, если consumer завершился
+    // по простою (try_retire)
+    bool batch_consumer_loop(Clock::time_point& idle_since) {
+        std::vector<T> batch;
+        batch.reserve(batching_.max_batch);
+        
+        size_t limit = batching_.initial_batch;
+        Clock::duration linger{0};
+        const Clock::duration max_linger = batching_.max_linger;
+        const Clock::duration linger_step = max_linger / 8 + Clock::duration(1);
+        
+        while (running_.load(std::memory_order_relaxed)) {
+            size_t dequeued = queue_.try_dequeue_batch(std::back_inserter(batch), limit);
+            
+            if (dequeued == 0) {
+                if (try_retire(idle_since)) {
+                    return true;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            
+            auto first_item = Clock::now();
+            
+            // Дозаполняем пачку, пока не истек linger
+            if (batch.size() < limit && linger > Clock::duration::zero()) {
+                auto linger_until = first_item + linger;
+                while (batch.size() < limit && Clock::now() < linger_until) {
+                    if (queue_.try_dequeue_batch(std::back_inserter(batch),
+                                                 limit - batch.size()) == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            
+            bool full = batch.size() >= limit;
+            batch_processor_(std::span<T>(batch.data(), batch.size()));
+            
+            auto done = Clock::now();
+            batches_processed_.fetch_add(1, std::memory_order_relaxed);
+            batched_items_.fetch_add(batch.size(), std::memory_order_relaxed);
+            batch.clear();
+            idle_since = done;
+            
+            // Задержка первого элемента пачки: linger + обработка всей пачки
+            if (done - first_item > batching_.target_latency) {
+                // Пачка слишком медленная - уменьшаем ее и отключаем linger
+                limit = std::max(limit / 2, batching_.min_batch);
+                linger = Clock::duration::zero();
+            } else if (full) {
+                // Очередь успевает заполнять пачку - высокая нагрузка
+                limit = std::min(limit * 2, batching_.max_batch);
+                linger = std::min(linger + linger_step, max_linger);
+            } else {
+                // Низкая нагрузка - не задерживаем элементы
+                linger /= 2;
+            }
+            
+            current_batch_limit_.store(limit, std::memory_order_relaxed);
+            current_linger_ns_.store(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(linger).count(),
+                std::memory_order_relaxed);
+        }
+        
+        // Обрабатываем оставшиеся элементы до крайнего срока
+        while (before_drain_deadline() &&
+               queue_.try_dequeue_batch(std::back_inserter(batch), batching_.max_batch) > 0) {
+            batch_processor_(std::span<T>(batch.data(), batch.size()));
+            batch.clear();
+        }
+        return false;
+    }
+    
+    // Вызывается под consumers_mutex_
+    void spawn_consumer() {
+        auto consumer = std::make_unique<Consumer>();
+        Consumer* raw = consumer.get();
+        active_consumers_.fetch_add(1, std::memory_order_relaxed);
+        raw->thread = std::thread([this, raw]() { consumer_loop(*raw); });
+        consumers_.push_back(std::move(consumer));
+    }
+    
+    // Вызывается под consumers_mutex_: join завершившихся consumer'ов
+    void reap_finished_consumers() {
+        auto it = std::remove_if(consumers_.begin(), consumers_.end(),
+            [](std::unique_ptr<Consumer>& c) {
+                if (!c->finished.load(std::memory_order_acquire)) {
+                    return false;
+                }
+                c->thread.join();
+                return true;
+            });
+        consumers_.erase(it, consumers_.end());
+    }
+    
+    void supervisor_loop() {
+        size_t last_dequeued = queue_.get_statistics().total_dequeued;
+        size_t last_blocked = blocked_produces_.load(std::memory_order_relaxed);
+        auto last_check = Clock::now();
+        
+        while (running_.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(scaling_.check_interval);
+            
+            auto now = Clock::now();
+            double interval_s = std::chrono::duration<double>(now - last_check).count();
+            last_check = now;
+            
+            size_t dequeued = queue_.get_statistics().total_dequeued;
+            size_t blocked = blocked_produces_.load(std::memory_order_relaxed);
+            double rate = interval_s > 0 ? (dequeued - last_dequeued) / interval_s : 0.0;
+            bool producer_blocked = blocked != last_blocked;
+            last_dequeued = dequeued;
+            last_blocked = blocked;
+            
+            size_t size = queue_.size();
+            double occupancy = static_cast<double>(size) / Capacity;
+            double wait_s = size == 0 ? 0.0 :
+                            rate > 0 ? size / rate : std::chrono::duration<double>::max().count();
+            
+            std::lock_guard<std::mutex> lock(consumers_mutex_);
+            reap_finished_consumers();
+            
+            bool overloaded = producer_blocked ||
+                occupancy >= scaling_.scale_up_occupancy ||
+                wait_s >= std::chrono::duration<double>(scaling_.scale_up_wait).count();
+            
+            // Добавляем не более одного consumer'а за интервал, чтобы не раскачивать пул
+            if (overloaded &&
+                active_consumers_.load(std::memory_order_relaxed) < scaling_.max_consumers) {
+                spawn_consumer();
+                scale_ups_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    // Обработка элемента в потоке producer'а (CallerRuns)
+    template<typename U>
+    void run_in_caller(U&& item) {
+        if (item_processor_) {
+            item_processor_(T(std::forward<U>(item)));
+        } else if (batch_processor_) {
+            T single(std::forward<U>(item));
+            batch_processor_(std::span<T>(&single, 1));
+        }
     }
     
 public:
@@ -330,24 +757,90 @@ public:
     template<typename BatchProcessor>
     ManagedSPMCSystem(BatchProcessor&& batch_processor, 
                      size_t num_consumers,
-                     bool /* batch_tag */)
-        : batch_processor_(std::forward<BatchProcessor>(batch_processor)) {
+                     bool /* batch_tag */,
+                     const SPMCBatchConfig& batching = {})
+        : batching_(batching),
+          batch_processor_(make_batch_processor(std::forward<BatchProcessor>(batch_processor))) {
         
         start_consumers(num_consumers, true);
     }
     
+    // Автомасштабируемый пул: от min_consumers до max_consumers
+    template<typename ItemProcessor>
+    ManagedSPMCSystem(ItemProcessor&& processor, const SPMCScalingConfig& scaling)
+        : item_processor_(std::forward<ItemProcessor>(processor)) {
+        
+        start_autoscaling(scaling, false);
+    }
+    
+    template<typename BatchProcessor>
+    ManagedSPMCSystem(BatchProcessor&& batch_processor,
+                     const SPMCScalingConfig& scaling,
+                     bool /* batch_tag */,
+                     const SPMCBatchConfig& batching = {})
+        : batching_(batching),
+          batch_processor_(make_batch_processor(std::forward<BatchProcessor>(batch_processor))) {
+        
+        start_autoscaling(scaling, true);
+    }
+    
     ~ManagedSPMCSystem() {
         stop();
     }
     
+    void set_backpressure_policy(BackpressurePolicy policy) {
+        policy_.store(policy, std::memory_order_relaxed);
+    }
+    
+    BackpressurePolicy backpressure_policy() const {
+        return policy_.load(std::memory_order_relaxed);
+    }
+    
     template<typename U>
     bool try_produce(U&& item) {
         return queue_.try_enqueue(std::forward<U>(item));
     }
     
+    // Возвращает false, если элемент был отброшен (DropNewest)
     template<typename U>
-    void produce(U&& item) {
-        queue_.enqueue(std::forward<U>(item));
+    bool produce(U&& item) {
+        if (queue_.try_enqueue(std::forward<U>(item))) {
+            return true;
+        }
+        
+        switch (policy_.load(std::memory_order_relaxed)) {
+        case BackpressurePolicy::Block: {
+            auto start = Clock::now();
+            blocked_produces_.fetch_add(1, std::memory_order_relaxed);
+            queue_.enqueue(std::forward<U>(item));
+            blocked_time_ns_.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - start).count(),
+                std::memory_order_relaxed);
+            return true;
+        }
+        
+        case BackpressurePolicy::DropOldest:
+            // Producer отбрасывает не больше одного самого старого элемента.
+            // Слот producer'а освобождается, только когда consumer,
+            // захвативший голову очереди, вернет его - ждем, как при Block
+            if (queue_.try_drop_oldest()) {
+                dropped_oldest_.fetch_add(1, std::memory_order_relaxed);
+            }
+            queue_.enqueue(std::forward<U>(item));
+            return true;
+        
+        case BackpressurePolicy::DropNewest:
+            dropped_newest_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        
+        case BackpressurePolicy::CallerRuns:
+            caller_runs_.fetch_add(1, std::memory_order_relaxed);
+            run_in_caller(std::forward<U>(item));
+            return true;
+        }
+        
+        return false;
     }
     
     template<typename Iterator>
@@ -356,27 +849,118 @@ public:
     }
     
     void stop() {
+        stop(Clock::duration::max());
+    }
+    
+    // Останавливает систему, давая consumer'ам не более drain_timeout на
+    // обработку оставшихся элементов. Возвращает true, если очередь опустела;
+    // необработанные элементы разрушаются вместе с очередью.
+    template<typename Rep, typename Period>
+    bool stop(const std::chrono::duration<Rep, Period>& drain_timeout) {
+        auto now = Clock::now();
+        auto deadline = drain_timeout >= Clock::time_point::max() - now
+            ? Clock::time_point::max()
+            : now + std::chrono::duration_cast<Clock::duration>(drain_timeout);
+        drain_deadline_.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+        
         running_.store(false, std::memory_order_relaxed);
         
+        if (supervisor_.joinable()) {
+            supervisor_.join();
+        }
+        
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
         for (auto& consumer : consumers_) {
-            if (consumer.joinable()) {
-                consumer.join();
+            if (consumer->thread.joinable()) {
+                consumer->thread.join();
             }
         }
         consumers_.clear();
+        
+        return queue_.empty();
     }
     
     auto get_statistics() const {
         return queue_.get_statistics();
     }
     
+    struct BackpressureStatistics {
+        BackpressurePolicy policy;
+        size_t blocked_produces;
+        uint64_t blocked_time_ns;
+        size_t dropped_oldest;
+        size_t dropped_newest;
+        size_t caller_runs;
+    };
+    
+    BackpressureStatistics get_backpressure_statistics() const {
+        return {
+            policy_.load(std::memory_order_relaxed),
+            blocked_produces_.load(std::memory_order_relaxed),
+            blocked_time_ns_.load(std::memory_order_relaxed),
+            dropped_oldest_.load(std::memory_order_relaxed),
+            dropped_newest_.load(std::memory_order_relaxed),
+            caller_runs_.load(std::memory_order_relaxed)
+        };
+    }
+    
+    struct ScalingStatistics {
+        size_t active_consumers;
+        size_t scale_ups;
+        size_t scale_downs;
+    };
+    
+    ScalingStatistics get_scaling_statistics() const {
+        return {
+            active_consumers_.load(std::memory_order_relaxed),
+            scale_ups_.load(std::memory_order_relaxed),
+            scale_downs_.load(std::memory_order_relaxed)
+        };
+    }
+    
+    struct BatchStatistics {
+        size_t current_batch_limit;
+        uint64_t current_linger_ns;
+        size_t batches_processed;
+        double average_batch_size;
+    };
+    
+    BatchStatistics get_batch_statistics() const {
+        size_t batches = batches_processed_.load(std::memory_order_relaxed);
+        size_t items = batched_items_.load(std::memory_order_relaxed);
+        
+        return {
+            current_batch_limit_.load(std::memory_order_relaxed),
+            current_linger_ns_.load(std::memory_order_relaxed),
+            batches,
+            batches > 0 ? static_cast<double>(items) / batches : 0.0
+        };
+    }
+    
 private:
     void start_consumers(size_t num_consumers, bool use_batching) {
+        use_batching_ = use_batching;
+        
+        batching_.min_batch = std::max<size_t>(batching_.min_batch, 1);
+        batching_.max_batch = std::max(batching_.max_batch, batching_.min_batch);
+        batching_.initial_batch = std::clamp(batching_.initial_batch,
+                                             batching_.min_batch, batching_.max_batch);
+        current_batch_limit_.store(batching_.initial_batch, std::memory_order_relaxed);
+        
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
         consumers_.reserve(num_consumers);
         for (size_t i = 0; i < num_consumers; ++i) {
-            consumers_.emplace_back([this, i, use_batching]() {
-                consumer_loop(i, use_batching);
-            });
+            spawn_consumer();
         }
     }
+    
+    void start_autoscaling(const SPMCScalingConfig& scaling, bool use_batching) {
+        scaling_ = scaling;
+        scaling_.min_consumers = std::max<size_t>(scaling_.min_consumers, 1);
+        scaling_.max_consumers = std::max(scaling_.max_consumers, scaling_.min_consumers);
+        autoscaling_ = true;
+        
+        start_consumers(scaling_.min_consumers, use_batching);
+        supervisor_ = std::thread([this]() { supervisor_loop(); });
+    }
 };
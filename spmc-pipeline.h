@@ -0,0 +1,560 @@
+#include "single-produer-multiply-consumer.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Типизированный конвейер поверх SPMCQueue:
+//
+//   auto pipeline = spmc_pipeline::source<RawFrame>()
+//       | spmc_pipeline::stage(decode, 4)
+//       | spmc_pipeline::fused(normalize)          // без отдельной очереди
+//       | spmc_pipeline::ordered_stage(encode, 2)  // выход в порядке входа
+//       | spmc_pipeline::sink(write_packet);
+//
+//   pipeline.push(frame);   // из одного producer-потока
+//   pipeline.wait();        // дождаться обработки всех элементов
+//
+// Каждый поток стадии - единственный producer своей SPMC-очереди ("полосы"),
+// а потоки следующей стадии - ее consumer'ы. Так между стадиями не нужен
+// MPMC и нет type-erased вызовов на пути данных.
+namespace spmc_pipeline
+{
+    using Clock = std::chrono::steady_clock;
+
+    template<typename T>
+    struct Envelope {
+        uint64_t seq;
+        Clock::time_point enqueued;
+        T value;
+
+        template<typename U>
+        Envelope(uint64_t s, Clock::time_point t, U&& v)
+            : seq(s), enqueued(t), value(std::forward<U>(v)) {}
+    };
+
+    // Набор SPMC-очередей между двумя стадиями: по одной на producer-поток
+    template<typename T, size_t Capacity>
+    class Channel {
+    public:
+        using Queue = SPMCQueue<Envelope<T>, Capacity>;
+
+        explicit Channel(size_t lanes) {
+            for (size_t i = 0; i < lanes; ++i) {
+                lanes_.push_back(std::make_unique<Queue>());
+            }
+        }
+
+        size_t lanes() const { return lanes_.size(); }
+
+        // Только для producer'а полосы lane
+        template<typename U>
+        void push(size_t lane, uint64_t seq, U&& value) {
+            Queue& queue = *lanes_[lane];
+            while (!queue.try_emplace(seq, Clock::now(), std::forward<U>(value))) {
+                std::this_thread::yield();
+            }
+        }
+
+        // Обходит полосы по кругу начиная с cursor; элемент обрабатывается на месте
+        template<typename Handler>
+        bool try_consume(size_t& cursor, Handler&& handler) {
+            size_t count = lanes_.size();
+            for (size_t n = 0; n < count; ++n) {
+                size_t index = (cursor + n) % count;
+                auto item = lanes_[index]->try_peek();
+                if (item) {
+                    cursor = (index + 1) % count;
+                    handler(*item);
+                    lanes_[index]->release(item);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Все producer'ы завершились
+        void close() { closed_.store(true, std::memory_order_release); }
+
+        bool drained() const {
+            return closed_.load(std::memory_order_acquire) && empty();
+        }
+
+        bool empty() const {
+            for (const auto& lane : lanes_) {
+                if (!lane->empty()) return false;
+            }
+            return true;
+        }
+
+        size_t size() const {
+            size_t total = 0;
+            for (const auto& lane : lanes_) total += lane->size();
+            return total;
+        }
+
+    private:
+        std::vector<std::unique_ptr<Queue>> lanes_;
+        std::atomic<bool> closed_{false};
+    };
+
+    inline void idle_wait(uint32_t& idle_rounds) {
+        if (++idle_rounds < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    struct StageMetrics {
+        std::string name;
+        size_t parallelism;
+        bool ordered;
+        size_t fused_functions;
+        uint64_t processed;
+        double throughput_per_sec;
+        double average_service_ns;   // время работы функции стадии
+        double average_latency_ns;   // ожидание во входной очереди + обработка
+        uint64_t max_latency_ns;
+        size_t queued;
+    };
+
+    // Управляющий интерфейс стадии (виртуальные вызовы только вне пути данных)
+    class StageBase {
+    public:
+        // Сколько элементов может опережать самый старый незавершенный перед
+        // переупорядочивающей стадией; push() ждет, пока окно не освободится
+        static constexpr uint64_t REORDER_WINDOW = 256;
+
+        StageBase(std::string name, size_t parallelism, bool ordered, size_t fused)
+            : name_(std::move(name)), parallelism_(std::max<size_t>(parallelism, 1)),
+              ordered_(ordered), fused_(fused) {}
+
+        virtual ~StageBase() = default;
+
+        virtual void start() = 0;
+        virtual void join() = 0;
+        virtual size_t queued() const = 0;
+
+        // Для переупорядочивающей стадии - seq следующего элемента, который
+        // она выдаст; nullptr, если стадия порядок не восстанавливает
+        virtual const std::atomic<uint64_t>* reorder_progress() const { return nullptr; }
+
+        StageMetrics metrics() const {
+            uint64_t processed = processed_.load(std::memory_order_relaxed);
+            double elapsed = std::chrono::duration<double>(Clock::now() - started_).count();
+
+            return {
+                name_,
+                parallelism_,
+                ordered_,
+                fused_,
+                processed,
+                elapsed > 0 ? processed / elapsed : 0.0,
+                processed ? double(service_ns_.load(std::memory_order_relaxed)) / processed : 0.0,
+                processed ? double(latency_ns_.load(std::memory_order_relaxed)) / processed : 0.0,
+                max_latency_ns_.load(std::memory_order_relaxed),
+                queued()
+            };
+        }
+
+    protected:
+        void record(Clock::time_point enqueued, Clock::time_point begin, Clock::time_point end) {
+            auto service = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+            uint64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end - enqueued).count();
+
+            processed_.fetch_add(1, std::memory_order_relaxed);
+            service_ns_.fetch_add(service, std::memory_order_relaxed);
+            latency_ns_.fetch_add(latency, std::memory_order_relaxed);
+
+            uint64_t max = max_latency_ns_.load(std::memory_order_relaxed);
+            while (latency > max &&
+                   !max_latency_ns_.compare_exchange_weak(max, latency, std::memory_order_relaxed)) {
+            }
+        }
+
+        std::string name_;
+        size_t parallelism_;
+        bool ordered_;
+        size_t fused_;
+        Clock::time_point started_ = Clock::now();
+        std::vector<std::thread> threads_;
+
+    private:
+        std::atomic<uint64_t> processed_{0};
+        std::atomic<uint64_t> service_ns_{0};
+        std::atomic<uint64_t> latency_ns_{0};
+        std::atomic<uint64_t> max_latency_ns_{0};
+    };
+
+    // Промежуточная стадия In -> Out с parallelism потоками
+    template<typename In, typename Out, typename F, size_t Capacity>
+    class StageRunner : public StageBase {
+    public:
+        StageRunner(std::string name, Channel<In, Capacity>& input, F fn,
+                    size_t parallelism, bool ordered, size_t fused)
+            : StageBase(std::move(name), parallelism, ordered, fused),
+              input_(input), fn_(std::move(fn)), worker_out_(parallelism_) {
+            // Порядок теряется и при нескольких потоках стадии, и при
+            // нескольких входных полосах (их обход идет по кругу)
+            if (ordered_ && (parallelism_ > 1 || input_.lanes() > 1)) {
+                ordered_out_ = std::make_unique<Channel<Out, Capacity>>(1);
+            }
+        }
+
+        Channel<Out, Capacity>& output() {
+            return ordered_out_ ? *ordered_out_ : worker_out_;
+        }
+
+        void start() override {
+            started_ = Clock::now();
+            live_workers_.store(parallelism_, std::memory_order_relaxed);
+            for (size_t i = 0; i < parallelism_; ++i) {
+                threads_.emplace_back([this, i]() { worker_loop(i); });
+            }
+            if (ordered_out_) {
+                threads_.emplace_back([this]() { reorder_loop(); });
+            }
+        }
+
+        void join() override {
+            for (auto& thread : threads_) {
+                if (thread.joinable()) thread.join();
+            }
+            threads_.clear();
+        }
+
+        size_t queued() const override { return input_.size(); }
+
+        const std::atomic<uint64_t>* reorder_progress() const override {
+            return ordered_out_ ? &released_seq_ : nullptr;
+        }
+
+    private:
+        void worker_loop(size_t lane) {
+            F fn = fn_; // у каждого потока своя копия (stateful-функции)
+            size_t cursor = lane;
+            uint32_t idle_rounds = 0;
+
+            while (true) {
+                bool got = input_.try_consume(cursor, [&](Envelope<In>& item) {
+                    auto begin = Clock::now();
+                    worker_out_.push(lane, item.seq, fn(std::move(item.value)));
+                    record(item.enqueued, begin, Clock::now());
+                });
+
+                if (got) {
+                    idle_rounds = 0;
+                } else if (input_.drained()) {
+                    break;
+                } else {
+                    idle_wait(idle_rounds);
+                }
+            }
+
+            if (live_workers_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                worker_out_.close();
+            }
+        }
+
+        // Собирает выходы потоков и выдает их строго по seq. pending не
+        // больше REORDER_WINDOW: дальше окна Pipeline::push не пускает
+        void reorder_loop() {
+            std::map<uint64_t, Out> pending;
+            uint64_t next_seq = 0;
+            size_t cursor = 0;
+            uint32_t idle_rounds = 0;
+
+            while (true) {
+                bool got = worker_out_.try_consume(cursor, [&](Envelope<Out>& item) {
+                    if (item.seq == next_seq) {
+                        ordered_out_->push(0, next_seq++, std::move(item.value));
+                    } else {
+                        pending.emplace(item.seq, std::move(item.value));
+                    }
+                    while (!pending.empty() && pending.begin()->first == next_seq) {
+                        ordered_out_->push(0, next_seq++, std::move(pending.begin()->second));
+                        pending.erase(pending.begin());
+                    }
+                    released_seq_.store(next_seq, std::memory_order_release);
+                });
+
+                if (got) {
+                    idle_rounds = 0;
+                } else if (worker_out_.drained()) {
+                    break;
+                } else {
+                    idle_wait(idle_rounds);
+                }
+            }
+
+            ordered_out_->close();
+        }
+
+        Channel<In, Capacity>& input_;
+        F fn_;
+        Channel<Out, Capacity> worker_out_;
+        std::unique_ptr<Channel<Out, Capacity>> ordered_out_;
+        std::atomic<uint64_t> released_seq_{0};
+        std::atomic<size_t> live_workers_{0};
+    };
+
+    // Завершающая стадия
+    template<typename In, typename F, size_t Capacity>
+    class SinkRunner : public StageBase {
+    public:
+        SinkRunner(Channel<In, Capacity>& input, F fn, size_t parallelism)
+            : StageBase("sink", parallelism, false, 0), input_(input), fn_(std::move(fn)) {}
+
+        void start() override {
+            started_ = Clock::now();
+            for (size_t i = 0; i < parallelism_; ++i) {
+                threads_.emplace_back([this, i]() { worker_loop(i); });
+            }
+        }
+
+        void join() override {
+            for (auto& thread : threads_) {
+                if (thread.joinable()) thread.join();
+            }
+            threads_.clear();
+        }
+
+        size_t queued() const override { return input_.size(); }
+
+    private:
+        void worker_loop(size_t index) {
+            F fn = fn_;
+            size_t cursor = index;
+            uint32_t idle_rounds = 0;
+
+            while (true) {
+                bool got = input_.try_consume(cursor, [&](Envelope<In>& item) {
+                    auto begin = Clock::now();
+                    fn(std::move(item.value));
+                    record(item.enqueued, begin, Clock::now());
+                });
+
+                if (got) {
+                    idle_rounds = 0;
+                } else if (input_.drained()) {
+                    break;
+                } else {
+                    idle_wait(idle_rounds);
+                }
+            }
+        }
+
+        Channel<In, Capacity>& input_;
+        F fn_;
+    };
+
+    // Описания стадий, из которых собирается конвейер
+
+    template<typename F>
+    struct StageSpec {
+        F fn;
+        size_t parallelism;
+        bool ordered;
+        size_t fused;
+    };
+
+    template<typename F>
+    struct FusedSpec {
+        F fn;
+    };
+
+    template<typename F>
+    struct SinkSpec {
+        F fn;
+        size_t parallelism;
+    };
+
+    template<typename F>
+    StageSpec<std::decay_t<F>> stage(F&& fn, size_t parallelism = 1) {
+        return {std::forward<F>(fn), parallelism, false, 0};
+    }
+
+    // Выход стадии передается дальше в порядке поступления на вход конвейера
+    template<typename F>
+    StageSpec<std::decay_t<F>> ordered_stage(F&& fn, size_t parallelism = 1) {
+        return {std::forward<F>(fn), parallelism, true, 0};
+    }
+
+    // Дешевая функция, выполняемая в потоках предыдущей стадии без отдельной очереди
+    template<typename F>
+    FusedSpec<std::decay_t<F>> fused(F&& fn) {
+        return {std::forward<F>(fn)};
+    }
+
+    template<typename F>
+    SinkSpec<std::decay_t<F>> sink(F&& fn, size_t parallelism = 1) {
+        return {std::forward<F>(fn), parallelism};
+    }
+
+    // g(f(x)) одним вызовом
+    template<typename F, typename G>
+    struct Composed {
+        F f;
+        G g;
+
+        template<typename X>
+        decltype(auto) operator()(X&& x) {
+            return g(f(std::forward<X>(x)));
+        }
+    };
+
+    struct Identity {
+        template<typename X>
+        std::decay_t<X> operator()(X&& x) const { return std::forward<X>(x); }
+    };
+
+    template<typename In, size_t Capacity, typename Pre, typename Specs, typename SinkFn>
+    class Pipeline;
+
+    template<typename In, size_t Capacity, typename Pre, typename... Specs>
+    class PipelineBuilder {
+    public:
+        Pre pre;
+        std::tuple<Specs...> specs;
+
+        template<typename F>
+        friend auto operator|(PipelineBuilder&& builder, StageSpec<F> spec) {
+            return PipelineBuilder<In, Capacity, Pre, Specs..., StageSpec<F>>{
+                std::move(builder.pre),
+                std::tuple_cat(std::move(builder.specs), std::make_tuple(std::move(spec)))};
+        }
+
+        template<typename G>
+        friend auto operator|(PipelineBuilder&& builder, FusedSpec<G> spec) {
+            if constexpr (sizeof...(Specs) == 0) {
+                // Перед первой стадией - выполняется в потоке push()
+                return PipelineBuilder<In, Capacity, Composed<Pre, G>>{
+                    Composed<Pre, G>{std::move(builder.pre), std::move(spec.fn)}, {}};
+            } else {
+                return std::move(builder).fuse_last(std::move(spec.fn),
+                    std::make_index_sequence<sizeof...(Specs) - 1>{});
+            }
+        }
+
+        template<typename F>
+        friend auto operator|(PipelineBuilder&& builder, SinkSpec<F> spec) {
+            return Pipeline<In, Capacity, Pre, std::tuple<Specs...>, F>(
+                std::move(builder.pre), std::move(builder.specs), std::move(spec));
+        }
+
+    private:
+        template<typename G, size_t... I>
+        auto fuse_last(G g, std::index_sequence<I...>) && {
+            auto& last = std::get<sizeof...(Specs) - 1>(specs);
+            using LastFn = decltype(last.fn);
+            using Fused = StageSpec<Composed<LastFn, G>>;
+
+            return PipelineBuilder<In, Capacity, Pre,
+                                   std::tuple_element_t<I, std::tuple<Specs...>>..., Fused>{
+                std::move(pre),
+                {std::move(std::get<I>(specs))...,
+                 Fused{Composed<LastFn, G>{std::move(last.fn), std::move(g)},
+                       last.parallelism, last.ordered, last.fused + 1}}};
+        }
+    };
+
+    template<typename In, size_t Capacity = 1024>
+    PipelineBuilder<In, Capacity, Identity> source() {
+        return {};
+    }
+
+    template<typename In, size_t Capacity, typename Pre, typename Specs, typename SinkFn>
+    class Pipeline {
+    private:
+        using Head = std::invoke_result_t<Pre&, In&&>;
+
+        Pre pre_;
+        Channel<Head, Capacity> source_{1};
+        uint64_t next_seq_ = 0;
+        std::vector<std::unique_ptr<StageBase>> stages_;
+        std::vector<const std::atomic<uint64_t>*> reorder_progress_;
+        bool finished_ = false;
+
+        template<size_t I, typename X>
+        void build(Specs& specs, Channel<X, Capacity>& input, SinkSpec<SinkFn>& sink) {
+            if constexpr (I == std::tuple_size_v<Specs>) {
+                stages_.push_back(std::make_unique<SinkRunner<X, SinkFn, Capacity>>(
+                    input, std::move(sink.fn), sink.parallelism));
+            } else {
+                auto& spec = std::get<I>(specs);
+                using F = decltype(spec.fn);
+                using Out = std::decay_t<std::invoke_result_t<F&, X&&>>;
+
+                auto runner = std::make_unique<StageRunner<X, Out, F, Capacity>>(
+                    "stage " + std::to_string(I), input, std::move(spec.fn),
+                    spec.parallelism, spec.ordered, spec.fused);
+                auto& output = runner->output();
+                stages_.push_back(std::move(runner));
+                build<I + 1>(specs, output, sink);
+            }
+        }
+
+    public:
+        Pipeline(Pre pre, Specs specs, SinkSpec<SinkFn> sink)
+            : pre_(std::move(pre)) {
+            build<0>(specs, source_, sink);
+            for (auto& stage : stages_) {
+                if (auto progress = stage->reorder_progress()) {
+                    reorder_progress_.push_back(progress);
+                }
+                stage->start();
+            }
+        }
+
+        ~Pipeline() {
+            wait();
+        }
+
+        Pipeline(const Pipeline&) = delete;
+        Pipeline& operator=(const Pipeline&) = delete;
+
+        // Single Producer - блокируется, пока во входной очереди нет места
+        // или элемент вышел бы за окно переупорядочивания
+        template<typename U>
+        void push(U&& item) {
+            for (const auto* progress : reorder_progress_) {
+                uint32_t idle_rounds = 0;
+                while (next_seq_ - progress->load(std::memory_order_acquire) >= StageBase::REORDER_WINDOW) {
+                    idle_wait(idle_rounds);
+                }
+            }
+            source_.push(0, next_seq_++, pre_(std::forward<U>(item)));
+        }
+
+        // Больше элементов не будет: стадии завершатся, обработав очереди
+        void close() {
+            source_.close();
+        }
+
+        void wait() {
+            if (finished_) return;
+            close();
+            for (auto& stage : stages_) {
+                stage->join();
+            }
+            finished_ = true;
+        }
+
+        std::vector<StageMetrics> metrics() const {
+            std::vector<StageMetrics> result;
+            result.reserve(stages_.size());
+            for (const auto& stage : stages_) {
+                result.push_back(stage->metrics());
+            }
+            return result;
+        }
+    };
+}
@@ -7,64 +7,1616 @@
 #include <iomanip>
 #include <sstream>
 #include <map>
+#include <memory>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <exception>
+#include <stdexcept>
+#include <fstream>
+#include <condition_variable>
+#include <type_traits>
+#include <system_error>
+#include <cerrno>
+#include <cstdio>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Лог-линейная гистограмма в духе HdrHistogram: значения до 2^SUB_BUCKET_BITS
+// хранятся точно, дальше каждая степень двойки делится на 2^(SUB_BUCKET_BITS-1)
+// линейных поддиапазонов - относительная ошибка не больше 1/32 (~3%).
+// Размер фиксирован (~10 КБ), значения больше 2^MAX_VALUE_BITS нс (~4.9 ч)
+// попадают в последнюю корзину.
+//
+// record() - fetch_add, безопасен из любых потоков; record_single_writer() -
+// load + store, когда в гистограмму пишет только один поток (шард монитора).
+// Читатели (копирование, merge, percentile) работают параллельно с записью
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 6;
+    static constexpr uint32_t MAX_VALUE_BITS = 44;
+    static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t(1) << SUB_BUCKET_BITS;
+    static constexpr uint64_t HALF_SUB_BUCKET_COUNT = SUB_BUCKET_COUNT / 2;
+    static constexpr size_t BUCKET_COUNT =
+        SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * HALF_SUB_BUCKET_COUNT;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+
+    static void add_single_writer(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+public:
+    static size_t bucket_index(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<size_t>(value);
+        }
+
+        uint32_t highest_bit = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+        if (highest_bit >= MAX_VALUE_BITS) {
+            return BUCKET_COUNT - 1;
+        }
+
+        uint32_t shift = highest_bit - SUB_BUCKET_BITS + 1;
+        return static_cast<size_t>(SUB_BUCKET_COUNT + (shift - 1) * HALF_SUB_BUCKET_COUNT +
+                                   ((value >> shift) - HALF_SUB_BUCKET_COUNT));
+    }
+
+    // Наибольшее значение, попадающее в корзину (как highestEquivalentValue в HDR)
+    static uint64_t bucket_upper_bound(size_t index) {
+        if (index < SUB_BUCKET_COUNT) {
+            return index;
+        }
+
+        uint64_t shift = (index - SUB_BUCKET_COUNT) / HALF_SUB_BUCKET_COUNT + 1;
+        uint64_t sub_bucket = (index - SUB_BUCKET_COUNT) % HALF_SUB_BUCKET_COUNT + HALF_SUB_BUCKET_COUNT;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+
+    LatencyHistogram() = default;
+
+    // Копия - снимок текущих значений
+    LatencyHistogram(const LatencyHistogram& other) {
+        merge(other);
+    }
+
+    LatencyHistogram& operator=(const LatencyHistogram& other) {
+        if (this != &other) {
+            reset();
+            merge(other);
+        }
+        return *this;
+    }
+
+    void record(uint64_t value) {
+        buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void record_single_writer(uint64_t value) {
+        add_single_writer(buckets_[bucket_index(value)], 1);
+        add_single_writer(count_, 1);
+        add_single_writer(sum_, value);
+    }
+
+    // Не атомарно относительно параллельных merge/subtract в эту же гистограмму
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            if (uint64_t n = other.buckets_[i].load(std::memory_order_relaxed)) {
+                add_single_writer(buckets_[i], n);
+            }
+        }
+        add_single_writer(count_, other.count_.load(std::memory_order_relaxed));
+        add_single_writer(sum_, other.sum_.load(std::memory_order_relaxed));
+    }
+
+    // Окно: *this - накопленный снимок, earlier - снимок начала окна
+    void subtract(const LatencyHistogram& earlier) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            uint64_t current = buckets_[i].load(std::memory_order_relaxed);
+            uint64_t before = earlier.buckets_[i].load(std::memory_order_relaxed);
+            buckets_[i].store(current > before ? current - before : 0, std::memory_order_relaxed);
+        }
+        uint64_t count = count_.load(std::memory_order_relaxed);
+        uint64_t earlier_count = earlier.count_.load(std::memory_order_relaxed);
+        count_.store(count > earlier_count ? count - earlier_count : 0, std::memory_order_relaxed);
+        uint64_t sum = sum_.load(std::memory_order_relaxed);
+        uint64_t earlier_sum = earlier.sum_.load(std::memory_order_relaxed);
+        sum_.store(sum > earlier_sum ? sum - earlier_sum : 0, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t sum() const {
+        return sum_.load(std::memory_order_relaxed);
+    }
+
+    double mean() const {
+        uint64_t n = count();
+        return n ? static_cast<double>(sum()) / n : 0.0;
+    }
+
+    // percentile в [0, 100]; 0 для пустой гистограммы
+    uint64_t percentile(double percentile) const {
+        uint64_t total = 0;
+        for (const auto& bucket : buckets_) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) {
+            return 0;
+        }
+
+        uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total + 0.5);
+        target = std::max<uint64_t>(1, std::min(target, total));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                return bucket_upper_bound(i);
+            }
+        }
+        return bucket_upper_bound(BUCKET_COUNT - 1);
+    }
+
+    uint64_t max() const {
+        for (size_t i = BUCKET_COUNT; i > 0; --i) {
+            if (buckets_[i - 1].load(std::memory_order_relaxed)) {
+                return bucket_upper_bound(i - 1);
+            }
+        }
+        return 0;
+    }
+};
+
+// Аппаратные счетчики текущего потока через perf_event_open (Linux): одна
+// группа cycles/instructions/cache misses/branch misses, включаемая и
+// читаемая атомарно. Если ядро разрешило rdpmc (cap_user_rdpmc в
+// mmap-странице события), чтение идет из user space без системного вызова,
+// иначе - один read() группы. Если хоть один счетчик не открылся (нет PMU
+// в виртуалке, perf_event_paranoid, seccomp), available() == false и
+// read() возвращает невалидный Sample - мониторинг остается только по времени
+class PerfCounters {
+public:
+    enum Counter { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, COUNTER_COUNT };
+
+    struct Sample {
+        std::array<uint64_t, COUNTER_COUNT> values{};
+        bool valid = false;
+
+        Sample operator-(const Sample& start) const {
+            Sample delta;
+            delta.valid = valid && start.valid;
+            for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+                delta.values[i] = values[i] - start.values[i];
+            }
+            return delta;
+        }
+    };
+
+    static const char* name(size_t counter) {
+        static const char* const names[COUNTER_COUNT] = {
+            "cycles", "instructions", "cache_misses", "branch_misses"};
+        return names[counter];
+    }
+
+private:
+#if defined(__linux__)
+    std::array<int, COUNTER_COUNT> fds_;
+    std::array<perf_event_mmap_page*, COUNTER_COUNT> pages_{};
+    size_t page_size_ = 0;
+    bool available_ = false;
+    bool use_rdpmc_ = false;
+
+    static int open_counter(uint64_t config, int group_fd) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = group_fd == -1;      // группа включается через лидера
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    void close_all() {
+        for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+            if (pages_[i]) {
+                ::munmap(pages_[i], page_size_);
+                pages_[i] = nullptr;
+            }
+            if (fds_[i] >= 0) {
+                ::close(fds_[i]);
+                fds_[i] = -1;
+            }
+        }
+        available_ = false;
+        use_rdpmc_ = false;
+    }
+
+    // Протокол из linux/perf_event.h: seqlock по page->lock, значение =
+    // offset + знаково расширенный rdpmc. false - счетчик сейчас не на PMU
+    bool read_rdpmc(Sample& sample) const {
+#if defined(__x86_64__) || defined(__i386__)
+        for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+            const volatile perf_event_mmap_page* page = pages_[i];
+            uint32_t sequence;
+            uint64_t value;
+            do {
+                sequence = page->lock;
+                std::atomic_signal_fence(std::memory_order_acq_rel);
+                uint32_t index = page->index;
+                if (!page->cap_user_rdpmc || index == 0) {
+                    return false;
+                }
+                uint32_t width = page->pmc_width;
+                int64_t pmc = static_cast<int64_t>(static_cast<uint64_t>(__rdpmc(index - 1)) << (64 - width));
+                value = page->offset + (pmc >> (64 - width));
+                std::atomic_signal_fence(std::memory_order_acq_rel);
+            } while (page->lock != sequence);
+            sample.values[i] = value;
+        }
+        sample.valid = true;
+        return true;
+#else
+        (void)sample;
+        return false;
+#endif
+    }
+
+    PerfCounters() {
+        fds_.fill(-1);
+        static const uint64_t configs[COUNTER_COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+        for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+            fds_[i] = open_counter(configs[i], i == 0 ? -1 : fds_[0]);
+            if (fds_[i] < 0) {
+                close_all();
+                return;
+            }
+        }
+        available_ = true;
+
+        page_size_ = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        use_rdpmc_ = true;
+        for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+            void* page = ::mmap(nullptr, page_size_, PROT_READ, MAP_SHARED, fds_[i], 0);
+            if (page == MAP_FAILED) {
+                use_rdpmc_ = false;
+                break;
+            }
+            pages_[i] = static_cast<perf_event_mmap_page*>(page);
+            use_rdpmc_ = use_rdpmc_ && pages_[i]->cap_user_rdpmc;
+        }
+
+        ::ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+public:
+    ~PerfCounters() {
+        close_all();
+    }
+
+    bool available() const {
+        return available_;
+    }
+
+    bool uses_rdpmc() const {
+        return use_rdpmc_;
+    }
+
+    Sample read() const {
+        Sample sample;
+        if (!available_ || (use_rdpmc_ && read_rdpmc(sample))) {
+            return sample;
+        }
+
+        struct {
+            uint64_t count;
+            uint64_t values[COUNTER_COUNT];
+        } group;
+        if (::read(fds_[0], &group, sizeof(group)) == static_cast<ssize_t>(sizeof(group)) &&
+            group.count == COUNTER_COUNT) {
+            std::copy(std::begin(group.values), std::end(group.values), sample.values.begin());
+            sample.valid = true;
+        }
+        return sample;
+    }
+#else
+    PerfCounters() = default;
+
+public:
+    bool available() const {
+        return false;
+    }
+
+    bool uses_rdpmc() const {
+        return false;
+    }
+
+    Sample read() const {
+        return {};
+    }
+#endif
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Счетчики считают только открывший их поток, поэтому группа - на поток
+    static PerfCounters& for_current_thread() {
+        thread_local PerfCounters counters;
+        return counters;
+    }
+};
+
+// Монитор задач с шардами на поток: запись - relaxed load/store в память,
+// которой владеет только текущий поток, без блокировок, RMW и поиска
+// по map. Шард потока регистрируется при первой записи; print_report()
+// лениво суммирует шарды, не останавливая пишущие потоки. Память
+// ограничена: не больше MAX_SHARDS шардов фиксированного размера, потоки
+// сверх лимита пишут в общий шард переполнения. Времена выполнения
+// хранятся в LatencyHistogram, поэтому отчет показывает хвосты, а не
+// только среднее; задачи с PerfCounters::Sample дополнительно копят
+// аппаратные счетчики
 class ThreadMonitor {
 public:
     struct ThreadStats {
+        std::thread::id thread_id;
         uint64_t total_tasks = 0;
         uint64_t failed_tasks = 0;
         uint64_t total_exec_time_ns = 0;
-        std::vector<uint64_t> exec_times_ns;
+        LatencyHistogram exec_times_ns;
+        uint64_t counted_tasks = 0;     // задачи с валидными аппаратными счетчиками
+        std::array<uint64_t, PerfCounters::COUNTER_COUNT> counters{};
     };
 
+    static constexpr size_t MAX_SHARDS = 1024;
+
 private:
-    std::mutex stats_mutex;
-    std::map<std::thread::id, ThreadStats> stats;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // Собственный шард потока пишет только он сам (load + store). Шард
+    // переполнения и шарды для записи от имени другого потока - shared,
+    // в них пишут через fetch_add
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        std::atomic<uint64_t> total_tasks{0};
+        std::atomic<uint64_t> failed_tasks{0};
+        LatencyHistogram exec_times_ns;
+        std::atomic<uint64_t> counted_tasks{0};
+        std::array<std::atomic<uint64_t>, PerfCounters::COUNTER_COUNT> counters{};
+        std::thread::id owner;
+        bool shared = false;
+        Shard* next = nullptr;
+    };
+
+    // Запись кеша потока: шард монитора. Кеш - thread_local вектор,
+    // индексируемый плотным номером монитора (slot_), так что поток,
+    // пишущий в несколько мониторов (MetricRegistry), находит свой шард за
+    // O(1). Номера переиспользуются после разрушения монитора, поэтому
+    // запись проверяется по уникальному id, а не по адресу
+    struct ShardCache {
+        uint64_t monitor_id = 0;
+        Shard* shard = nullptr;
+    };
+
+    static uint64_t next_monitor_id() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // Свободные номера мониторов; объект не разрушается, чтобы мониторы
+    // со статическим временем жизни могли вернуть номер при выходе
+    struct SlotAllocator {
+        std::mutex mutex;
+        std::vector<uint32_t> free;
+        uint32_t next = 0;
+    };
+
+    static SlotAllocator& slot_allocator() {
+        static SlotAllocator& allocator = *new SlotAllocator;
+        return allocator;
+    }
+
+    static uint32_t acquire_slot() {
+        SlotAllocator& allocator = slot_allocator();
+        std::lock_guard<std::mutex> lock(allocator.mutex);
+        if (allocator.free.empty()) {
+            return allocator.next++;
+        }
+        uint32_t slot = allocator.free.back();
+        allocator.free.pop_back();
+        return slot;
+    }
+
+    static void release_slot(uint32_t slot) {
+        SlotAllocator& allocator = slot_allocator();
+        std::lock_guard<std::mutex> lock(allocator.mutex);
+        allocator.free.push_back(slot);
+    }
+
+    static std::vector<ShardCache>& thread_cache() {
+        thread_local std::vector<ShardCache> cache;
+        return cache;
+    }
+
+    const uint64_t id_ = next_monitor_id();
+    const uint32_t slot_ = acquire_slot();
+    std::atomic<Shard*> shards_{nullptr};       // только добавление в начало
+    std::atomic<size_t> shard_count_{0};
+    Shard overflow_;
+    std::mutex registration_mutex_;             // только для регистрации шарда
+
+    // Накопленный снимок на начало текущего окна (только для читателей)
+    std::mutex window_mutex_;
+    std::map<std::thread::id, ThreadStats> window_start_;
+
+    Shard* find_shard(std::thread::id tid, bool shared) {
+        for (Shard* shard = shards_.load(std::memory_order_acquire); shard; shard = shard->next) {
+            if (shard->owner == tid && shard->shared == shared) {
+                return shard;
+            }
+        }
+        return nullptr;
+    }
+
+    Shard* register_shard(std::thread::id tid, bool shared) {
+        std::lock_guard<std::mutex> lock(registration_mutex_);
+
+        if (Shard* shard = find_shard(tid, shared)) {
+            return shard;
+        }
+        if (shard_count_.load(std::memory_order_relaxed) >= MAX_SHARDS) {
+            return &overflow_;
+        }
+
+        Shard* shard = new Shard;
+        shard->owner = tid;
+        shard->shared = shared;
+        shard->next = shards_.load(std::memory_order_relaxed);
+        shards_.store(shard, std::memory_order_release);
+        shard_count_.fetch_add(1, std::memory_order_relaxed);
+        return shard;
+    }
+
+    Shard* shard_for(std::thread::id tid) {
+        bool own_thread = tid == std::this_thread::get_id();
+
+        if (own_thread) {
+            std::vector<ShardCache>& cache = thread_cache();
+            if (slot_ < cache.size() && cache[slot_].monitor_id == id_) [[likely]] {
+                return cache[slot_].shard;
+            }
+        }
+
+        // Чужой поток: отдельный shared-шард, собственный остается однописательным
+        Shard* shard = find_shard(tid, !own_thread);
+        if (!shard) {
+            shard = register_shard(tid, !own_thread);
+        }
+        if (own_thread) {
+            std::vector<ShardCache>& cache = thread_cache();
+            if (slot_ >= cache.size()) {
+                cache.resize(slot_ + 1);
+            }
+            cache[slot_] = {id_, shard};
+        }
+        return shard;
+    }
+
+    static void add(const Shard& shard, std::atomic<uint64_t>& counter, uint64_t value) {
+        if (shard.shared) {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        } else {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    }
+
+    static void record(Shard& s, uint64_t exec_time_ns, bool success, const PerfCounters::Sample* counters) {
+        add(s, s.total_tasks, 1);
+        if (!success) add(s, s.failed_tasks, 1);
+        if (s.shared) {
+            s.exec_times_ns.record(exec_time_ns);
+        } else {
+            s.exec_times_ns.record_single_writer(exec_time_ns);
+        }
+
+        if (counters && counters->valid) {
+            add(s, s.counted_tasks, 1);
+            for (size_t i = 0; i < PerfCounters::COUNTER_COUNT; ++i) {
+                add(s, s.counters[i], counters->values[i]);
+            }
+        }
+    }
 
 public:
+    ThreadMonitor() {
+        overflow_.shared = true;
+    }
+
+    ~ThreadMonitor() {
+        release_slot(slot_);
+        Shard* shard = shards_.load(std::memory_order_acquire);
+        while (shard) {
+            Shard* next = shard->next;
+            delete shard;
+            shard = next;
+        }
+    }
+
+    ThreadMonitor(const ThreadMonitor&) = delete;
+    ThreadMonitor& operator=(const ThreadMonitor&) = delete;
+
     void record_task(std::thread::id tid, uint64_t exec_time_ns, bool success = true) {
-        std::lock_guard<std::mutex> lock(stats_mutex);
-        auto& s = stats[tid];
-        s.total_tasks++;
-        if (!success) s.failed_tasks++;
-        s.total_exec_time_ns += exec_time_ns;
-        s.exec_times_ns.push_back(exec_time_ns);
+        record(*shard_for(tid), exec_time_ns, success, nullptr);
+    }
+
+    // Запись от имени текущего потока
+    void record_task(uint64_t exec_time_ns, bool success = true) {
+        record(*shard_for(std::this_thread::get_id()), exec_time_ns, success, nullptr);
+    }
+
+    // Запись от имени текущего потока вместе с приращением его счетчиков
+    void record_task(uint64_t exec_time_ns, const PerfCounters::Sample& counters, bool success = true) {
+        record(*shard_for(std::this_thread::get_id()), exec_time_ns, success, &counters);
+    }
+
+    // Согласованность между счетчиками одного шарда не гарантируется:
+    // запись может идти параллельно со снимком
+    std::vector<ThreadStats> snapshot() const {
+        // Порядок потоков как у прежнего std::map; собственный и shared-шард
+        // одного потока складываются
+        std::map<std::thread::id, ThreadStats> merged;
+        auto read = [&merged](const Shard& shard, std::thread::id tid) {
+            ThreadStats& s = merged[tid];
+            s.thread_id = tid;
+            s.total_tasks += shard.total_tasks.load(std::memory_order_relaxed);
+            s.failed_tasks += shard.failed_tasks.load(std::memory_order_relaxed);
+            s.exec_times_ns.merge(shard.exec_times_ns);
+            s.total_exec_time_ns = s.exec_times_ns.sum();
+            s.counted_tasks += shard.counted_tasks.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < PerfCounters::COUNTER_COUNT; ++i) {
+                s.counters[i] += shard.counters[i].load(std::memory_order_relaxed);
+            }
+        };
+
+        for (Shard* shard = shards_.load(std::memory_order_acquire); shard; shard = shard->next) {
+            read(*shard, shard->owner);
+        }
+        read(overflow_, std::thread::id());
+
+        std::vector<ThreadStats> result;
+        for (const auto& [tid, s] : merged) {
+            if (s.total_tasks) result.push_back(s);
+        }
+        return result;
+    }
+
+    // Статистика за окно с предыдущего вызова take_window() (с создания
+    // монитора для первого). Пишущие потоки ничего не сбрасывают: окно -
+    // разность двух накопленных снимков
+    std::vector<ThreadStats> take_window() {
+        std::vector<ThreadStats> current = snapshot();
+        std::lock_guard<std::mutex> lock(window_mutex_);
+
+        std::vector<ThreadStats> window;
+        for (const ThreadStats& s : current) {
+            ThreadStats delta = s;
+            auto previous = window_start_.find(s.thread_id);
+            if (previous != window_start_.end()) {
+                delta.total_tasks -= previous->second.total_tasks;
+                delta.failed_tasks -= previous->second.failed_tasks;
+                delta.exec_times_ns.subtract(previous->second.exec_times_ns);
+                delta.total_exec_time_ns = delta.exec_times_ns.sum();
+                delta.counted_tasks -= previous->second.counted_tasks;
+                for (size_t i = 0; i < PerfCounters::COUNTER_COUNT; ++i) {
+                    delta.counters[i] -= previous->second.counters[i];
+                }
+            }
+            window_start_[s.thread_id] = s;
+            if (delta.total_tasks) window.push_back(delta);
+        }
+        return window;
+    }
+
+    static void print_stats(const std::vector<ThreadStats>& stats) {
+        auto ms = [](uint64_t ns) { return ns / 1e6; };
+        auto print_row = [&](const ThreadStats& s) {
+            std::cout << s.total_tasks << " tasks, "
+                      << s.failed_tasks << " failed, "
+                      << std::fixed << std::setprecision(2)
+                      << "avg " << ms(static_cast<uint64_t>(s.exec_times_ns.mean())) << " ms, "
+                      << "p50 " << ms(s.exec_times_ns.percentile(50)) << ", "
+                      << "p90 " << ms(s.exec_times_ns.percentile(90)) << ", "
+                      << "p99 " << ms(s.exec_times_ns.percentile(99)) << ", "
+                      << "p99.9 " << ms(s.exec_times_ns.percentile(99.9)) << ", "
+                      << "max " << ms(s.exec_times_ns.max()) << " ms\n";
+
+            // Аппаратные счетчики - средние на задачу, рядом с временем
+            if (s.counted_tasks) {
+                double tasks = static_cast<double>(s.counted_tasks);
+                std::cout << "    per task: ";
+                for (size_t i = 0; i < PerfCounters::COUNTER_COUNT; ++i) {
+                    std::cout << PerfCounters::name(i) << " " << s.counters[i] / tasks << ", ";
+                }
+                double cycles = static_cast<double>(s.counters[PerfCounters::CYCLES]);
+                std::cout << "IPC " << (cycles ? s.counters[PerfCounters::INSTRUCTIONS] / cycles : 0.0) << "\n";
+            }
+        };
+
+        ThreadStats all;
+        for (const auto& s : stats) {
+            std::cout << "Thread ";
+            if (s.thread_id == std::thread::id()) std::cout << "(overflow)"; else std::cout << s.thread_id;
+            std::cout << ": ";
+            print_row(s);
+
+            all.total_tasks += s.total_tasks;
+            all.failed_tasks += s.failed_tasks;
+            all.exec_times_ns.merge(s.exec_times_ns);
+            all.counted_tasks += s.counted_tasks;
+            for (size_t i = 0; i < PerfCounters::COUNTER_COUNT; ++i) {
+                all.counters[i] += s.counters[i];
+            }
+        }
+        std::cout << "All threads: ";
+        print_row(all);
     }
 
     void print_report() {
-        std::lock_guard<std::mutex> lock(stats_mutex);
         std::cout << "Thread Performance Report:\n";
-        for (const auto& [tid, s] : stats) {
-            double avg = s.total_tasks ? s.total_exec_time_ns / double(s.total_tasks) : 0;
-            std::cout << "Thread " << tid << ": "
-                      << s.total_tasks << " tasks, "
-                      << s.failed_tasks << " failed, "
-                      << "avg exec " << std::fixed << std::setprecision(2) << avg / 1e6 << " ms\n";
+        print_stats(snapshot());
+    }
+};
+
+// Часы для ScopedTimer: now() в собственных единицах, to_ns() переводит
+// разность. TscClock читает rdtsc и калибруется по steady_clock один раз;
+// корректен при инвариантном TSC (constant_tsc/nonstop_tsc), иначе - SteadyClock
+struct SteadyClock {
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t to_ns(uint64_t elapsed) {
+        return elapsed;
+    }
+};
+
+struct TscClock {
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return SteadyClock::now();
+#endif
+    }
+
+    static double ticks_per_ns() {
+        static const double ratio = []() {
+#if defined(__x86_64__) || defined(__i386__)
+            auto start_time = std::chrono::steady_clock::now();
+            uint64_t start_ticks = now();
+            while (std::chrono::steady_clock::now() - start_time < std::chrono::milliseconds(2)) {
+            }
+            uint64_t elapsed_ticks = now() - start_ticks;
+            double elapsed_ns = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start_time).count();
+            return elapsed_ticks / elapsed_ns;
+#else
+            return 1.0;
+#endif
+        }();
+        return ratio;
+    }
+
+    static uint64_t to_ns(uint64_t elapsed) {
+        return static_cast<uint64_t>(elapsed / ticks_per_ns());
+    }
+};
+
+// Запись интервалов в формате Chrome trace-event JSON (открывается в
+// chrome://tracing и ui.perfetto.dev). Каждый поток пишет завершенные
+// интервалы ("ph":"X") в свое SPSC-кольцо фиксированного размера без
+// блокировок; фоновый поток раз в flush_interval переносит их в файл.
+// Память ограничена max_threads * events_per_thread событиями: при полном
+// кольце или сверх лимита одновременно живых потоков событие отбрасывается
+// и учитывается в dropped(), пишущий поток никогда не ждет. Буфер
+// завершившегося потока после выгрузки достается новому потоку, так что
+// лимит касается только одновременно пишущих потоков. Время - тики TscClock
+class TraceRecorder {
+public:
+    static constexpr size_t DEFAULT_EVENTS_PER_THREAD = 4096;
+    static constexpr size_t DEFAULT_MAX_THREADS = 256;
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // name должен жить до записи в файл (обычно строковый литерал)
+    struct Event {
+        const char* name;
+        uint64_t begin_ticks;
+        uint64_t end_ticks;
+    };
+
+    struct ThreadBuffer {
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head{0};    // пишет владелец
+        std::atomic<uint64_t> dropped{0};                          // пишет владелец
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail{0};    // пишет фоновый поток
+        std::atomic<bool> active{true};                            // занят живым потоком
+        std::unique_ptr<Event[]> events;
+        uint32_t thread_index = 0;
+        uint32_t named_index = 0;                                  // только фоновый поток
+        ThreadBuffer* next = nullptr;
+    };
+
+    struct BufferCache {
+        uint64_t recorder_id = 0;
+        ThreadBuffer* buffer = nullptr;
+    };
+
+    // id живых регистраторов: поток при выходе освобождает буфер, только
+    // если его регистратор еще не разрушен. Объект не разрушается, потому
+    // что потоки могут завершаться после статических деструкторов
+    struct LiveRecorders {
+        std::mutex mutex;
+        std::vector<uint64_t> ids;
+
+        bool contains(uint64_t id) const {
+            return std::find(ids.begin(), ids.end(), id) != ids.end();
+        }
+    };
+
+    static LiveRecorders& live_recorders() {
+        static LiveRecorders& instance = *new LiveRecorders;
+        return instance;
+    }
+
+    // Буферы потока во всех регистраторах; при выходе потока они помечаются
+    // свободными и переиспользуются register_buffer после выгрузки
+    struct ThreadBuffers {
+        std::vector<BufferCache> entries;
+
+        ~ThreadBuffers() {
+            LiveRecorders& live = live_recorders();
+            std::lock_guard<std::mutex> lock(live.mutex);
+            for (const BufferCache& entry : entries) {
+                if (entry.buffer && live.contains(entry.recorder_id)) {
+                    entry.buffer->active.store(false, std::memory_order_release);
+                }
+            }
+        }
+    };
+
+    static uint64_t next_recorder_id() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    const uint64_t id_ = next_recorder_id();
+    const size_t capacity_;
+    const size_t max_threads_;
+
+    std::atomic<bool> active_{false};
+    std::atomic<ThreadBuffer*> buffers_{nullptr};   // только добавление в начало
+    std::atomic<uint64_t> unregistered_dropped_{0};
+    std::mutex registration_mutex_;
+    size_t buffer_count_ = 0;
+    uint32_t thread_count_ = 0;
+
+    // Состояние сессии записи; start/stop сериализуются session_mutex_
+    std::mutex session_mutex_;
+    std::mutex flush_mutex_;
+    std::condition_variable flush_cv_;
+    bool stop_requested_ = false;
+    std::thread flusher_;
+    std::ofstream out_;
+    bool first_event_ = true;
+    uint64_t start_ticks_ = 0;
+    std::chrono::milliseconds flush_interval_{50};
+
+    static size_t round_up_to_power_of_two(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    ThreadBuffer* register_buffer() {
+        std::lock_guard<std::mutex> lock(registration_mutex_);
+
+        // Буфер завершившегося потока берем, только когда фоновый поток
+        // выгрузил его целиком, иначе новые события затрут невыгруженные.
+        // acquire на active синхронизируется с release при выходе потока,
+        // так что head ниже не старше последней записи прежнего владельца
+        for (ThreadBuffer* buffer = buffers_.load(std::memory_order_relaxed); buffer; buffer = buffer->next) {
+            bool expected = false;
+            if (!buffer->active.load(std::memory_order_acquire) &&
+                buffer->tail.load(std::memory_order_acquire) == buffer->head.load(std::memory_order_relaxed) &&
+                buffer->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                buffer->thread_index = ++thread_count_;
+                return buffer;
+            }
+        }
+
+        if (buffer_count_ >= max_threads_) {
+            return nullptr;
+        }
+
+        auto buffer = new ThreadBuffer;
+        buffer->events.reset(new Event[capacity_]);
+        buffer->thread_index = ++thread_count_;
+        buffer->next = buffers_.load(std::memory_order_relaxed);
+        buffers_.store(buffer, std::memory_order_release);
+        ++buffer_count_;
+        return buffer;
+    }
+
+    ThreadBuffer* buffer_for_current_thread() {
+        thread_local ThreadBuffers buffers;
+        for (const BufferCache& entry : buffers.entries) {
+            if (entry.recorder_id == id_) {
+                return entry.buffer;
+            }
+        }
+
+        // Записи разрушенных регистраторов больше не нужны
+        {
+            LiveRecorders& live = live_recorders();
+            std::lock_guard<std::mutex> lock(live.mutex);
+            std::erase_if(buffers.entries, [&](const BufferCache& entry) {
+                return !live.contains(entry.recorder_id);
+            });
+        }
+
+        ThreadBuffer* buffer = register_buffer();
+        buffers.entries.push_back({id_, buffer});
+        return buffer;
+    }
+
+    static void write_escaped(std::ostream& out, const char* text) {
+        for (; *text; ++text) {
+            char c = *text;
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                out << ' ';
+            } else {
+                out << c;
+            }
+        }
+    }
+
+    void write_separator() {
+        if (!first_event_) {
+            out_ << ",\n";
+        }
+        first_event_ = false;
+    }
+
+    // Выполняется только фоновым потоком или в stop() после его остановки
+    void drain() {
+        double ticks_per_us = TscClock::ticks_per_ns() * 1000.0;
+
+        for (ThreadBuffer* buffer = buffers_.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+            uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            if (tail == head) {
+                continue;
+            }
+
+            // thread_index меняется при переиспользовании буфера: поток
+            // записал его до публикации событий через head
+            if (buffer->named_index != buffer->thread_index) {
+                write_separator();
+                out_ << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_index
+                     << ",\"args\":{\"name\":\"thread " << buffer->thread_index << "\"}}";
+                buffer->named_index = buffer->thread_index;
+            }
+
+            for (; tail != head; ++tail) {
+                const Event& event = buffer->events[tail & (capacity_ - 1)];
+                // События, начатые до start() (в том числе из прошлой сессии), пропускаем
+                if (event.begin_ticks < start_ticks_) {
+                    continue;
+                }
+                write_separator();
+                out_ << "{\"name\":\"";
+                write_escaped(out_, event.name);
+                out_ << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_index
+                     << ",\"ts\":" << (event.begin_ticks - start_ticks_) / ticks_per_us
+                     << ",\"dur\":" << (event.end_ticks - event.begin_ticks) / ticks_per_us << "}";
+            }
+            buffer->tail.store(head, std::memory_order_release);
+        }
+        out_.flush();
+    }
+
+    void flush_loop() {
+        std::unique_lock<std::mutex> lock(flush_mutex_);
+        while (!stop_requested_) {
+            flush_cv_.wait_for(lock, flush_interval_);
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+public:
+    explicit TraceRecorder(size_t events_per_thread = DEFAULT_EVENTS_PER_THREAD,
+                           size_t max_threads = DEFAULT_MAX_THREADS)
+        : capacity_(round_up_to_power_of_two(std::max<size_t>(events_per_thread, 2))),
+          max_threads_(max_threads) {
+        LiveRecorders& live = live_recorders();
+        std::lock_guard<std::mutex> lock(live.mutex);
+        live.ids.push_back(id_);
+    }
+
+    ~TraceRecorder() {
+        stop();
+        {
+            LiveRecorders& live = live_recorders();
+            std::lock_guard<std::mutex> lock(live.mutex);
+            std::erase(live.ids, id_);
+        }
+        ThreadBuffer* buffer = buffers_.load(std::memory_order_acquire);
+        while (buffer) {
+            ThreadBuffer* next = buffer->next;
+            delete buffer;
+            buffer = next;
+        }
+    }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    void start(const std::string& path,
+               std::chrono::milliseconds flush_interval = std::chrono::milliseconds(50)) {
+        std::lock_guard<std::mutex> session(session_mutex_);
+        if (flusher_.joinable()) {
+            throw std::logic_error("TraceRecorder: trace already started");
+        }
+
+        out_.open(path, std::ios::out | std::ios::trunc);
+        if (!out_) {
+            throw std::runtime_error("TraceRecorder: cannot open " + path);
+        }
+        out_ << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+
+        first_event_ = true;
+        start_ticks_ = TscClock::now();
+        flush_interval_ = flush_interval;
+        stop_requested_ = false;
+        for (ThreadBuffer* buffer = buffers_.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+            buffer->named_index = 0;
+        }
+
+        flusher_ = std::thread(&TraceRecorder::flush_loop, this);
+        active_.store(true, std::memory_order_release);
+    }
+
+    // Дописывает накопленные события и закрывает файл
+    void stop() {
+        std::lock_guard<std::mutex> session(session_mutex_);
+        if (!flusher_.joinable()) {
+            return;
+        }
+
+        active_.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex_);
+            stop_requested_ = true;
         }
+        flush_cv_.notify_one();
+        flusher_.join();
+
+        drain();
+        out_ << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        out_.close();
+    }
+
+    bool active() const {
+        return active_.load(std::memory_order_relaxed);
+    }
+
+    // Завершенный интервал текущего потока; не блокируется
+    void record(const char* name, uint64_t begin_ticks, uint64_t end_ticks) {
+        if (!active()) {
+            return;
+        }
+
+        ThreadBuffer* buffer = buffer_for_current_thread();
+        if (!buffer) {
+            unregistered_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        if (head - buffer->tail.load(std::memory_order_acquire) >= capacity_) {
+            buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1,
+                                  std::memory_order_relaxed);
+            return;
+        }
+
+        buffer->events[head & (capacity_ - 1)] = {name, begin_ticks, end_ticks};
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    uint64_t dropped() const {
+        uint64_t total = unregistered_dropped_.load(std::memory_order_relaxed);
+        for (ThreadBuffer* buffer = buffers_.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+            total += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+};
+
+// Включение таймеров на этапе компиляции: -DMONITOR_ENABLED=0 в релизной
+// сборке превращает ScopedTimer<> в пустой объект, а MONITOR_SCOPE - в ничто
+#ifndef MONITOR_ENABLED
+#define MONITOR_ENABLED 1
+#endif
+
+// RAII-замер области видимости: время от конструктора до деструктора
+// записывается в монитор от имени текущего потока. Задача считается
+// неудачной, если вызван mark_failed() или область покидается исключением.
+// С TraceRecorder тот же интервал уходит и в трассу (только для TscClock)
+template<typename Clock = TscClock, bool Enabled = MONITOR_ENABLED>
+class ScopedTimer {
+private:
+    ThreadMonitor& monitor_;
+    TraceRecorder* trace_ = nullptr;
+    const char* trace_name_ = nullptr;
+    uint64_t start_;
+    int uncaught_exceptions_;
+    bool failed_ = false;
+
+public:
+    explicit ScopedTimer(ThreadMonitor& monitor)
+        : monitor_(monitor), start_(Clock::now()), uncaught_exceptions_(std::uncaught_exceptions()) {}
+
+    ScopedTimer(ThreadMonitor& monitor, TraceRecorder& trace, const char* trace_name)
+        : monitor_(monitor), trace_(&trace), trace_name_(trace_name),
+          start_(Clock::now()), uncaught_exceptions_(std::uncaught_exceptions()) {
+        static_assert(std::is_same_v<Clock, TscClock>, "TraceRecorder timestamps are TscClock ticks");
+    }
+
+    ~ScopedTimer() {
+        uint64_t end = Clock::now();
+        bool success = !failed_ && std::uncaught_exceptions() == uncaught_exceptions_;
+        monitor_.record_task(Clock::to_ns(end - start_), success);
+        if (trace_) {
+            trace_->record(trace_name_, start_, end);
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    void mark_failed() {
+        failed_ = true;
+    }
+};
+
+template<typename Clock>
+class ScopedTimer<Clock, false> {
+public:
+    explicit ScopedTimer(ThreadMonitor&) {}
+    ScopedTimer(ThreadMonitor&, TraceRecorder&, const char*) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    void mark_failed() {}
+};
+
+// ScopedTimer плюс приращение аппаратных счетчиков потока за область.
+// Без PerfCounters (available() == false) пишет только время
+template<typename Clock = TscClock, bool Enabled = MONITOR_ENABLED>
+class ScopedCounters {
+private:
+    ThreadMonitor& monitor_;
+    const PerfCounters& counters_;
+    PerfCounters::Sample start_counters_;
+    uint64_t start_;
+    int uncaught_exceptions_;
+    bool failed_ = false;
+
+public:
+    explicit ScopedCounters(ThreadMonitor& monitor)
+        : monitor_(monitor), counters_(PerfCounters::for_current_thread()),
+          start_counters_(counters_.read()), start_(Clock::now()),
+          uncaught_exceptions_(std::uncaught_exceptions()) {}
+
+    ~ScopedCounters() {
+        uint64_t end = Clock::now();
+        PerfCounters::Sample delta = counters_.read() - start_counters_;
+        bool success = !failed_ && std::uncaught_exceptions() == uncaught_exceptions_;
+        monitor_.record_task(Clock::to_ns(end - start_), delta, success);
+    }
+
+    ScopedCounters(const ScopedCounters&) = delete;
+    ScopedCounters& operator=(const ScopedCounters&) = delete;
+
+    void mark_failed() {
+        failed_ = true;
     }
 };
 
-// глобальный монитор
+template<typename Clock>
+class ScopedCounters<Clock, false> {
+public:
+    explicit ScopedCounters(ThreadMonitor&) {}
+
+    ScopedCounters(const ScopedCounters&) = delete;
+    ScopedCounters& operator=(const ScopedCounters&) = delete;
+
+    void mark_failed() {}
+};
+
+// Именованные метрики: у каждой свой ThreadMonitor с шардами на поток.
+// Поиск по имени под мьютексом - только при первом обращении из места
+// вызова, MONITOR_SCOPE кеширует ссылку в статической переменной
+class MetricRegistry {
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<ThreadMonitor>, std::less<>> metrics_;
+
+public:
+    ThreadMonitor& get(std::string_view name) {
+        // Калибровка TSC не должна попасть в первый замер
+        TscClock::ticks_per_ns();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = metrics_.find(name);
+        if (it == metrics_.end()) {
+            it = metrics_.emplace(std::string(name), std::make_unique<ThreadMonitor>()).first;
+        }
+        return *it->second;
+    }
+
+    // f(name, monitor) для каждой метрики; под мьютексом реестра
+    template<typename F>
+    void for_each(F&& f) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [name, monitor] : metrics_) {
+            f(name, *monitor);
+        }
+    }
+
+    void print_report() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [name, monitor] : metrics_) {
+            std::cout << "Metric " << name << ":\n";
+            ThreadMonitor::print_stats(monitor->snapshot());
+        }
+    }
+};
+
+// Периодический экспорт метрик в текстовом формате Prometheus. Фоновый
+// поток раз в interval снимает snapshot() каждого монитора (пишущие
+// потоки не останавливаются и не блокируются), считает приращения и
+// скорости за интервал и квантили по разности гистограмм. Результат
+// отдается по HTTP на 127.0.0.1:port (serve_http) и/или атомарно
+// переписывается в файл (write_to_file, подходит для textfile collector
+// node_exporter). Источники и выходы настраиваются до start()
+class MetricsExporter {
+private:
+    struct Source {
+        std::string name;
+        const ThreadMonitor* monitor = nullptr;
+        const MetricRegistry* registry = nullptr;
+    };
+
+    struct Previous {
+        uint64_t total_tasks = 0;
+        uint64_t failed_tasks = 0;
+        LatencyHistogram exec_times_ns;
+    };
+
+    std::chrono::milliseconds interval_;
+    std::vector<Source> sources_;
+    std::string file_path_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+
+    std::map<std::string, Previous> previous_;      // только поток снимков
+    std::chrono::steady_clock::time_point previous_time_;
+
+    mutable std::mutex latest_mutex_;
+    std::string latest_;
+
+    std::atomic<bool> running_{false};
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    bool stop_requested_ = false;
+    std::thread snapshot_thread_;
+    std::thread http_thread_;
+
+    static std::string escape_label(std::string_view value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                escaped += '\\';
+                escaped += c;
+            } else if (c == '\n') {
+                escaped += "\\n";
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    static void write_header(std::ostream& out, const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << " " << help << "\n"
+            << "# TYPE " << name << " " << type << "\n";
+    }
+
+    std::vector<std::pair<std::string, ThreadMonitor::ThreadStats>> collect() const {
+        std::vector<std::pair<std::string, ThreadMonitor::ThreadStats>> totals;
+        auto add = [&totals](const std::string& name, const ThreadMonitor& monitor) {
+            ThreadMonitor::ThreadStats all;
+            for (const auto& s : monitor.snapshot()) {
+                all.total_tasks += s.total_tasks;
+                all.failed_tasks += s.failed_tasks;
+                all.exec_times_ns.merge(s.exec_times_ns);
+                all.counted_tasks += s.counted_tasks;
+                for (size_t i = 0; i < PerfCounters::COUNTER_COUNT; ++i) {
+                    all.counters[i] += s.counters[i];
+                }
+            }
+            all.total_exec_time_ns = all.exec_times_ns.sum();
+            totals.emplace_back(name, std::move(all));
+        };
+
+        for (const Source& source : sources_) {
+            if (source.monitor) {
+                add(source.name, *source.monitor);
+            } else {
+                source.registry->for_each(add);
+            }
+        }
+        return totals;
+    }
+
+    std::string render() {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - previous_time_).count();
+        previous_time_ = now;
+
+        auto totals = collect();
+        std::ostringstream out;
+        out << std::setprecision(9);
+
+        write_header(out, "thread_monitor_tasks_total", "counter", "Tasks recorded.");
+        for (const auto& [name, s] : totals) {
+            out << "thread_monitor_tasks_total{metric=\"" << escape_label(name) << "\"} " << s.total_tasks << "\n";
+        }
+        write_header(out, "thread_monitor_failed_tasks_total", "counter", "Failed tasks recorded.");
+        for (const auto& [name, s] : totals) {
+            out << "thread_monitor_failed_tasks_total{metric=\"" << escape_label(name) << "\"} " << s.failed_tasks << "\n";
+        }
+
+        // Приращения за последний интервал: окно = текущий снимок - предыдущий
+        std::vector<std::pair<std::string, ThreadMonitor::ThreadStats>> windows;
+        for (const auto& [name, s] : totals) {
+            Previous& previous = previous_[name];
+            ThreadMonitor::ThreadStats window = s;
+            window.total_tasks -= std::min(previous.total_tasks, s.total_tasks);
+            window.failed_tasks -= std::min(previous.failed_tasks, s.failed_tasks);
+            window.exec_times_ns.subtract(previous.exec_times_ns);
+            previous.total_tasks = s.total_tasks;
+            previous.failed_tasks = s.failed_tasks;
+            previous.exec_times_ns = s.exec_times_ns;
+            windows.emplace_back(name, std::move(window));
+        }
+
+        write_header(out, "thread_monitor_task_rate", "gauge", "Tasks per second over the last interval.");
+        for (const auto& [name, w] : windows) {
+            out << "thread_monitor_task_rate{metric=\"" << escape_label(name) << "\"} "
+                << (seconds > 0 ? w.total_tasks / seconds : 0.0) << "\n";
+        }
+        write_header(out, "thread_monitor_failure_rate", "gauge", "Failed tasks per second over the last interval.");
+        for (const auto& [name, w] : windows) {
+            out << "thread_monitor_failure_rate{metric=\"" << escape_label(name) << "\"} "
+                << (seconds > 0 ? w.failed_tasks / seconds : 0.0) << "\n";
+        }
+
+        // Квантили - за последний интервал, _sum и _count - накопленные
+        write_header(out, "thread_monitor_latency_seconds", "summary",
+                     "Task latency; quantiles cover the last interval.");
+        for (size_t i = 0; i < totals.size(); ++i) {
+            std::string label = escape_label(totals[i].first);
+            const LatencyHistogram& window = windows[i].second.exec_times_ns;
+            for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+                out << "thread_monitor_latency_seconds{metric=\"" << label << "\",quantile=\"" << quantile << "\"} "
+                    << window.percentile(quantile * 100) / 1e9 << "\n";
+            }
+            out << "thread_monitor_latency_seconds_sum{metric=\"" << label << "\"} "
+                << totals[i].second.exec_times_ns.sum() / 1e9 << "\n"
+                << "thread_monitor_latency_seconds_count{metric=\"" << label << "\"} "
+                << totals[i].second.exec_times_ns.count() << "\n";
+        }
+
+        // Аппаратные счетчики - только для метрик, писавших их
+        write_header(out, "thread_monitor_counted_tasks_total", "counter",
+                     "Tasks recorded with hardware counters.");
+        for (const auto& [name, s] : totals) {
+            if (s.counted_tasks) {
+                out << "thread_monitor_counted_tasks_total{metric=\"" << escape_label(name) << "\"} "
+                    << s.counted_tasks << "\n";
+            }
+        }
+        write_header(out, "thread_monitor_hw_events_total", "counter",
+                     "Hardware events (perf_event_open) over counted tasks.");
+        for (const auto& [name, s] : totals) {
+            for (size_t c = 0; s.counted_tasks && c < PerfCounters::COUNTER_COUNT; ++c) {
+                out << "thread_monitor_hw_events_total{metric=\"" << escape_label(name)
+                    << "\",event=\"" << PerfCounters::name(c) << "\"} " << s.counters[c] << "\n";
+            }
+        }
+        return out.str();
+    }
+
+    void publish() {
+        std::string text = render();
+
+        if (!file_path_.empty()) {
+            std::string temporary = file_path_ + ".tmp";
+            {
+                std::ofstream file(temporary, std::ios::out | std::ios::trunc);
+                file << text;
+            }
+            std::rename(temporary.c_str(), file_path_.c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(latest_mutex_);
+        latest_ = std::move(text);
+    }
+
+    void snapshot_loop() {
+        std::unique_lock<std::mutex> lock(stop_mutex_);
+        while (!stop_requested_) {
+            if (stop_cv_.wait_for(lock, interval_, [this] { return stop_requested_; })) {
+                break;
+            }
+            lock.unlock();
+            publish();
+            lock.lock();
+        }
+    }
+
+    static void send_all(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    // Один запрос на соединение, ответ на любой путь - последний снимок
+    void http_loop() {
+        while (running_.load(std::memory_order_acquire)) {
+            pollfd listener{listen_fd_, POLLIN, 0};
+            if (::poll(&listener, 1, 100) <= 0) {
+                continue;
+            }
+            int client = ::accept(listen_fd_, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+
+            timeval timeout{1, 0};
+            ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            char request[1024];
+            ::recv(client, request, sizeof(request), 0);
+
+            std::string body = latest();
+            std::ostringstream response;
+            response << "HTTP/1.1 200 OK\r\n"
+                     << "Content-Type: text/plain; version=0.0.4\r\n"
+                     << "Content-Length: " << body.size() << "\r\n"
+                     << "Connection: close\r\n\r\n"
+                     << body;
+            send_all(client, response.str());
+            ::close(client);
+        }
+    }
+
+public:
+    explicit MetricsExporter(std::chrono::milliseconds interval = std::chrono::milliseconds(1000))
+        : interval_(interval) {}
+
+    ~MetricsExporter() {
+        stop();
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+        }
+    }
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Монитор и реестр должны пережить экспортер
+    void add(std::string name, const ThreadMonitor& monitor) {
+        sources_.push_back({std::move(name), &monitor, nullptr});
+    }
+
+    void add(const MetricRegistry& registry) {
+        sources_.push_back({"", nullptr, &registry});
+    }
+
+    void write_to_file(std::string path) {
+        file_path_ = std::move(path);
+    }
+
+    // port = 0 - любой свободный, фактический возвращает port()
+    void serve_http(uint16_t port) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "MetricsExporter: socket");
+        }
+        int reuse = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        socklen_t length = sizeof(address);
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            ::listen(fd, 16) < 0 ||
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "MetricsExporter: bind 127.0.0.1");
+        }
+
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+        }
+        listen_fd_ = fd;
+        port_ = ntohs(address.sin_port);
+    }
+
+    uint16_t port() const {
+        return port_;
+    }
+
+    void start() {
+        if (running_.exchange(true)) {
+            throw std::logic_error("MetricsExporter: already started");
+        }
+        stop_requested_ = false;
+        previous_time_ = std::chrono::steady_clock::now();
+        publish();
+
+        snapshot_thread_ = std::thread(&MetricsExporter::snapshot_loop, this);
+        if (listen_fd_ >= 0) {
+            http_thread_ = std::thread(&MetricsExporter::http_loop, this);
+        }
+    }
+
+    // Останавливает потоки и публикует последний снимок
+    void stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(stop_mutex_);
+            stop_requested_ = true;
+        }
+        stop_cv_.notify_one();
+        snapshot_thread_.join();
+        if (http_thread_.joinable()) {
+            http_thread_.join();
+        }
+        publish();
+    }
+
+    std::string latest() const {
+        std::lock_guard<std::mutex> lock(latest_mutex_);
+        return latest_;
+    }
+};
+
+// глобальный монитор, именованные метрики и трасса (пишется между
+// g_trace.start() и g_trace.stop())
 ThreadMonitor g_monitor;
+MetricRegistry g_metrics;
+TraceRecorder g_trace;
+
+#define MONITOR_CONCAT_IMPL(a, b) a##b
+#define MONITOR_CONCAT(a, b) MONITOR_CONCAT_IMPL(a, b)
+
+// MONITOR_SCOPE("name"); - замер до конца текущей области в метрику name
+// и, если трасса запущена, интервал name в g_trace. name - строковый литерал
+#if MONITOR_ENABLED
+#define MONITOR_SCOPE(name)                                                                  \
+    static ThreadMonitor& MONITOR_CONCAT(monitor_metric_, __LINE__) = g_metrics.get(name);   \
+    ScopedTimer<> MONITOR_CONCAT(monitor_timer_, __LINE__)(                                  \
+        MONITOR_CONCAT(monitor_metric_, __LINE__), g_trace, name)
+
+// MONITOR_SCOPE_COUNTERS("name"); - то же плюс аппаратные счетчики (без трассы)
+#define MONITOR_SCOPE_COUNTERS(name)                                                         \
+    static ThreadMonitor& MONITOR_CONCAT(monitor_metric_, __LINE__) = g_metrics.get(name);   \
+    ScopedCounters<> MONITOR_CONCAT(monitor_counters_, __LINE__)(MONITOR_CONCAT(monitor_metric_, __LINE__))
+#else
+#define MONITOR_SCOPE(name) static_cast<void>(0)
+#define MONITOR_SCOPE_COUNTERS(name) static_cast<void>(0)
+#endif
 
 // Обычная задача с мониторингом
 void monitored_task(int input) {
-    auto tid = std::this_thread::get_id();
-    auto start = std::chrono::high_resolution_clock::now();
+    ScopedTimer<SteadyClock> timer(g_monitor);
 
     // имитация работы и случайный сбой
-    bool success = true;
     try {
         if(input % 25 == 0) throw std::runtime_error("Simulated error");
         std::this_thread::sleep_for(std::chrono::milliseconds(10 + (input % 5)));
     } catch(...) {
-        success = false;
+        timer.mark_failed();
     }
+}
 
-    auto end = std::chrono::high_resolution_clock::now();
-    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+// Та же работа через именованную метрику: сбой - исключение из области
+void traced_task(int input) {
+    MONITOR_SCOPE("traced_task");
+    if(input % 25 == 0) throw std::runtime_error("Simulated error");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1 + (input % 3)));
+}
+
+void empty_scope() {
+    MONITOR_SCOPE("empty_scope");
+}
 
-    g_monitor.record_task(tid, ns, success);
+// Горячий цикл под аппаратными счетчиками
+uint64_t counted_loop(const std::vector<uint32_t>& data) {
+    MONITOR_SCOPE_COUNTERS("counted_loop");
+    uint64_t sum = 0;
+    for (uint32_t value : data) {
+        if (value & 1) sum += value;
+    }
+    return sum;
 }
 
 int main() {
@@ -72,17 +1624,63 @@ int main() {
     constexpr int NUM_TASKS = 60;
 
     std::vector<std::thread> threads;
+    g_trace.start("thread-monitor-trace.json");
+
+    MetricsExporter exporter(std::chrono::milliseconds(100));
+    exporter.add("monitored_task", g_monitor);
+    exporter.add(g_metrics);
+    exporter.write_to_file("thread-monitor-metrics.prom");
+    exporter.serve_http(0);
+    exporter.start();
+    std::cout << "Metrics at http://127.0.0.1:" << exporter.port() << "/metrics\n";
 
     for (int t = 0; t < NUM_THREADS; ++t) {
         threads.emplace_back([t]{
             for (int i = 0; i < NUM_TASKS; ++i) {
                 monitored_task(t * NUM_TASKS + i);
+                try {
+                    traced_task(t * NUM_TASKS + i);
+                } catch(...) {
+                }
             }
         });
     }
 
     for (auto& th : threads) th.join();
+    g_trace.stop();
+    exporter.stop();
 
     g_monitor.print_report();
+    g_metrics.print_report();
+    std::cout << "Trace written to thread-monitor-trace.json, dropped events: " << g_trace.dropped() << "\n";
+    std::cout << exporter.latest();
+
+    // Стоимость одной записи из одного потока
+    constexpr int NUM_RECORDS = 10000000;
+    ThreadMonitor cost_monitor;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_RECORDS; ++i) {
+        cost_monitor.record_task(static_cast<uint64_t>(i), i % 100 != 0);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "record_task: " << std::fixed << std::setprecision(2) << ns / NUM_RECORDS << " ns/sample\n";
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_RECORDS; ++i) {
+        empty_scope();
+    }
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "MONITOR_SCOPE: " << ns / NUM_RECORDS << " ns/scope\n";
+
+    const PerfCounters& counters = PerfCounters::for_current_thread();
+    std::cout << "Hardware counters: "
+              << (counters.available() ? (counters.uses_rdpmc() ? "rdpmc" : "read()") : "unavailable, timing only")
+              << "\n";
+    std::vector<uint32_t> data(1 << 16);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint32_t>(i * 2654435761u);
+    uint64_t checksum = 0;
+    for (int i = 0; i < 100; ++i) checksum += counted_loop(data);
+    std::cout << "Metric counted_loop (checksum " << checksum << "):\n";
+    ThreadMonitor::print_stats(g_metrics.get("counted_loop").snapshot());
     return 0;
 }